@@ -1,11 +1,35 @@
 #pragma once
 
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 #include <eosio/eosio.hpp>
 #include <eosio/singleton.hpp>
 #include <eosio/system.hpp>
 
+#include <map>
+#include <optional>
 #include <string>
+#include <tuple>
+#include <vector>
+
+// Feature variants (see README.txt). Every feature is on unless the build defines its
+// macro as 0; a feature that is off loses its actions, and its branches in the remaining
+// actions are compiled out through the constexpr flags of the token class.
+#ifndef RAINBOW_STAKING
+#define RAINBOW_STAKING 1       // setstake, settle and the stake transfers of issue and retire
+#endif
+#ifndef RAINBOW_DISPLAY
+#define RAINBOW_DISPLAY 1       // setdisplay and the display tables
+#endif
+#ifndef RAINBOW_MEMBERSHIP
+#define RAINBOW_MEMBERSHIP 1    // membership_mgr other than allowallacct
+#endif
+#ifndef RAINBOW_WITHDRAWAL
+#define RAINBOW_WITHDRAWAL 1    // withdrawal_mgr transfers to withdraw_to
+#endif
+#ifndef RAINBOW_RESETRAM
+#define RAINBOW_RESETRAM 1      // resetram
+#endif
 
 namespace eosio {
 
@@ -35,13 +59,20 @@ namespace eosio {
       public:
          using contract::contract;
 
+         static constexpr bool with_staking    = RAINBOW_STAKING;
+         static constexpr bool with_display    = RAINBOW_DISPLAY;
+         static constexpr bool with_membership = RAINBOW_MEMBERSHIP;
+         static constexpr bool with_withdrawal = RAINBOW_WITHDRAWAL;
+         static constexpr bool with_resetram   = RAINBOW_RESETRAM;
+
          /**
           * The ` create` action allows `issuer` account to create or reconfigure a token with the
           * specified characteristics. 
           * If the token does not exist, a new row in the stats table for token symbol scope is created
           * with the specified characteristics. At creation, its' approval flag is false, preventing
           * tokens from being issued. If a token of this symbol does exist and update
-          * is permitted, the characteristics are updated.
+          * is permitted, the characteristics are updated. Changing the precision of a token
+          * with outstanding supply starts a precision migration, completed by `migrate`.
           *
           * @param issuer - the account that creates the token,
           * @param maximum_supply - the maximum supply set for the token,
@@ -59,8 +90,10 @@ namespace eosio {
           *   the config_locked field in the configtable row must be in the past,
           * @pre maximum_supply has to be smaller than the maximum supply allowed by the system: 2^62 - 1.
           * @pre Maximum supply must be positive,
-          * @pre membership manager must be an existing account,
-          * @pre withdrawal manager must be an existing account,
+          * @pre membership manager must be an existing account, and allowallacct in builds
+          *   without membership control,
+          * @pre withdrawal manager must be an existing account, and the issuer in builds
+          *   without withdrawals, so that redeploying a build with them grants no new power,
           * @pre withdraw_to must be an existing account,
           * @pre freeze manager must be an existing account,
           * @pre membership manager must be an existing account;
@@ -81,7 +114,9 @@ namespace eosio {
          /**
           * By this action the contract owner approves or rejects the creation of the token. Until
           * this approval, no tokens may be issued. If rejected, and no issued tokens are outstanding,
-          * the table entries for this token are deleted.
+          * the table entries for this token are deleted. Tables with a row per holder are erased
+          * up to max_reject_erase rows per call; call again until the console reports the token
+          * rejected, as the token is deleted only once they are empty.
           *
           * @param symbolcode - the symbol_code of the token to execute the close action for.
           * @param reject_and_clear - if this flag is true, delete token; if false, approve creation
@@ -92,6 +127,7 @@ namespace eosio {
          void approve( const symbol_code& symbolcode, const bool& reject_and_clear );
 
 
+#if RAINBOW_STAKING
          /**
           * Allows `issuer` account to create or reconfigure a staking relationship for a token. If 
           * the relationship does not exist, a new entry in the stakes table for token symbol scope gets created. If there
@@ -125,11 +161,21 @@ namespace eosio {
                         const bool&   deferred,
                         const bool&   proportional,
                         const string& memo);
+#endif
 
+#if RAINBOW_DISPLAY
          /**
           * Allows `issuer` account to create or update display metadata for a token. All fields
           * except `name` and `json_meta` are expected to be urls. Issuer pays for RAM.
-          * The currency_display table is intended for apps to access (e.g. via nodeos chain API).
+          * The displayrefs table is intended for apps to access (e.g. via nodeos chain API):
+          * it holds the name and, for each other field, the id of a row in the blobs table
+          * (scoped on the contract account) holding the string, or 0 for an empty string.
+          * Identical strings share one blob across tokens; a blob is erased when its last
+          * reference is dropped. The displayrefs row is billed to `issuer`, but a shared blob
+          * stays billed to the issuer that first stored it until then, since moving its RAM
+          * would need the authority of the new payer. Tokens whose display was last set before
+          * displayrefs existed keep their strings in the displays table until this action is
+          * next run.
           *
           * @param issuer - the account that created the token,
           * @param symbol_code - the token,
@@ -149,6 +195,7 @@ namespace eosio {
                           const string&       background,
                           const string&       json_meta
          );
+#endif
 
          /**
           *  This action issues a `quantity` of tokens to the issuer account, and transfers
@@ -163,6 +210,57 @@ namespace eosio {
          [[eosio::action]]
          void issue( const asset& quantity, const string& memo );
 
+         /**
+          * Issues `total` tokens for distribution by Merkle proof instead of crediting them to
+          * the issuer. Supply and stake are accounted as for `issue`; the tokens are held by a
+          * new airdrops row until claimed. Each recipient is a leaf sha256( index, owner, amount ),
+          * hashing the three fields as packed in the `claim` action, and each parent node is
+          * sha256 of its two children concatenated in ascending byte order. The id of the new
+          * airdrop is printed.
+          *
+          * @param total - the sum of the leaf amounts,
+          * @param root - the Merkle root of the leaves,
+          * @param leaves - the number of leaves, indexed from 0,
+          * @param memo - the memo string that accompanies the airdrop.
+          *
+          * @pre The `approve` action must have been executed for this token symbol,
+          * @pre Transaction must have the issuer authority
+          */
+         [[eosio::action]]
+         void setdrop( const asset& total, const checksum256& root, const uint64_t& leaves, const string& memo );
+
+         /**
+          * Credits `owner` with `amount` from an airdrop, given the sibling hashes from the
+          * leaf ( index, owner, amount ) up to the root. Each index can be claimed once.
+          * Membership tokens may only be claimed into an existing balance row.
+          *
+          * @param symbolcode - the token,
+          * @param drop_id - the airdrop id printed by `setdrop`,
+          * @param index - the index of the leaf,
+          * @param owner - the account credited, paying RAM for its balance and claim records,
+          * @param amount - the amount of the leaf,
+          * @param proof - up to max_proof_length sibling hashes, leaf level first.
+          *
+          * @pre Transaction must have the owner authority
+          */
+         [[eosio::action]]
+         void claim( const symbol_code& symbolcode, const uint64_t& drop_id, const uint64_t& index,
+                     const name& owner, const asset& amount, const std::vector<checksum256>& proof );
+
+         /**
+          * Ends an airdrop. Unclaimed tokens are credited to the issuer on the first call, and up
+          * to `limit` claim records are erased per call; the airdrops row is erased with the last
+          * of them.
+          *
+          * @param symbolcode - the token,
+          * @param drop_id - the airdrop id,
+          * @param limit - max number of claim records to erase (for time control)
+          *
+          * @pre Transaction must have the issuer authority
+          */
+         [[eosio::action]]
+         void enddrop( const symbol_code& symbolcode, const uint64_t& drop_id, const uint32_t& limit );
+
          /**
           * The opposite for issue action, if all validations succeed,
           * it debits the statstable.supply amount. Any staked tokens are released from escrow in
@@ -195,6 +293,176 @@ namespace eosio {
                         const name&    to,
                         const asset&   quantity,
                         const string&  memo );
+
+         struct transfer_args {
+            name     from;
+            name     to;
+            asset    quantity;
+            string   memo;
+         };
+
+         /**
+          * Executes a batch of transfers, which may mix token symbols. Each row is
+          * validated exactly as by the `transfer` action, in order, but the stats and
+          * config rows of each token are read only once per batch, and balance changes
+          * to the same account are aggregated so that each balance row is written once.
+          *
+          * @param batch - vector of {from, to, quantity, memo} transfers.
+          *
+          * @pre Every row must satisfy the preconditions of the `transfer` action
+          */
+         [[eosio::action]]
+         void transfers( const std::vector<transfer_args>& batch );
+
+         /**
+          * Allows `spender` to move up to `quantity` of the owner's tokens with the
+          * `transferfrom` and `pullmany` actions until `expiry`. Replaces any allowance the
+          * owner gave the spender for that token; a zero quantity removes it. The allowance is
+          * erased when used up, returning its RAM to the owner.
+          *
+          * @param owner - the account whose tokens may be moved,
+          * @param spender - the account allowed to move them,
+          * @param quantity - the most the spender may move in total,
+          * @param expiry - time after which the allowance can no longer be used.
+          *
+          * @pre Transaction must have the owner authority,
+          * @pre expiry must be in the future unless quantity is zero
+          */
+         [[eosio::action]]
+         void setallowance( const name&            owner,
+                            const name&            spender,
+                            const asset&           quantity,
+                            const time_point_sec&  expiry );
+
+         /**
+          * Transfers `quantity` from `from` to `to` on the authority of `spender`, drawing
+          * on the allowance `from` gave the spender. The transfer is otherwise validated as
+          * by the `transfer` action with `from` as sender: it is frozen, rate limited and
+          * charged a fee alike, and the fee is paid from the balance of `from` without being
+          * drawn from the allowance.
+          *
+          * @param spender - the account holding the allowance,
+          * @param from - the account to transfer from,
+          * @param to - the account to be transferred to,
+          * @param quantity - the quantity of tokens to be transferred,
+          * @param memo - the memo string to accompany the transaction.
+          *
+          * @pre Transaction must have the spender authority,
+          * @pre from must have an unexpired allowance for spender of at least quantity
+          */
+         [[eosio::action]]
+         void transferfrom( const name&    spender,
+                            const name&    from,
+                            const name&    to,
+                            const asset&   quantity,
+                            const string&  memo );
+
+         /**
+          * Executes a batch of `transferfrom` transfers for one spender, which may pull from
+          * many owners and mix token symbols. As for `transfers`, the stats and config rows
+          * of each token are read once per batch and each balance row is written once; each
+          * allowance row is also read and written once, however many rows draw on it.
+          *
+          * @param spender - the account holding the allowances,
+          * @param batch - vector of {from, to, quantity, memo} transfers.
+          *
+          * @pre Every row must satisfy the preconditions of the `transferfrom` action
+          */
+         [[eosio::action]]
+         void pullmany( const name& spender, const std::vector<transfer_args>& batch );
+
+         /**
+          * Schedules a recurring payment of `quantity` from `payer` to `payee`, first due at
+          * `first_due` and then every `period` seconds, or once if `period` is zero. For a
+          * token without membership control the payee's balance is opened at the expense of
+          * `payer`. Payments are made by the `crank` action. The schedule id is printed.
+          *
+          * @param payer - the account to transfer from,
+          * @param payee - the account to be transferred to,
+          * @param quantity - the quantity of tokens paid on each due time,
+          * @param period - seconds between payments, zero for a single payment,
+          * @param first_due - time of the first payment,
+          * @param memo - the memo string to accompany the payments.
+          *
+          * @pre Transaction must have the payer authority,
+          * @pre The payee must have membership of the token,
+          * @pre first_due must not be in the past,
+          * @pre period must be zero or at least min_schedule_period
+          */
+         [[eosio::action]]
+         void schedule( const name&            payer,
+                        const name&            payee,
+                        const asset&           quantity,
+                        const uint32_t&        period,
+                        const time_point_sec&  first_due,
+                        const string&          memo );
+
+         /**
+          * Cancels a scheduled payment of token `symbolcode`.
+          *
+          * @param symbolcode - the token,
+          * @param id - the schedule id.
+          *
+          * @pre Transaction must have the payer or payee authority of the schedule
+          */
+         [[eosio::action]]
+         void unschedule( const symbol_code& symbolcode, const uint64_t& id );
+
+         /**
+          * Makes up to `limit` due scheduled payments of token `symbolcode`, earliest due
+          * first, with the checks and fee of the `transfer` action other than the payer
+          * authority, which was given to `schedule`. A payment that fails those checks, e.g.
+          * for lack of funds to cover it and its fee or over the payer's rate limit, is
+          * missed; either way the schedule moves on to its next due time, and a single
+          * payment schedule is removed. Any account may call this action.
+          *
+          * @param symbolcode - the token,
+          * @param limit - max number of due payments to make (for time control)
+          *
+          * @pre limit must be between 1 and max_crank_count,
+          * @pre The token must not be frozen, so that a freeze delays payments instead of
+          *   missing them
+          */
+         [[eosio::action]]
+         void crank( const symbol_code& symbolcode, const uint32_t& limit );
+
+         /**
+          * Transfers `quantity` from the issuer to `owner` and locks it in the owner's
+          * balance until vested: nothing vests before `start` + `cliff` seconds, and from
+          * then the locked amount falls linearly to zero at `start` + `duration` seconds,
+          * as if vesting had begun at `start`. The locked amount is computed when the owner
+          * spends, so vesting needs no further actions. An owner has at most one grant per
+          * token; a fully vested grant is replaced.
+          *
+          * @param owner - the account receiving the grant,
+          * @param quantity - the quantity of tokens granted,
+          * @param start - time vesting begins,
+          * @param cliff - seconds from start before anything vests,
+          * @param duration - seconds from start until everything has vested,
+          * @param memo - the memo string to accompany the transfer.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre cliff must not be greater than duration, and duration must be positive
+          */
+         [[eosio::action]]
+         void vest( const name&            owner,
+                    const asset&           quantity,
+                    const time_point_sec&  start,
+                    const uint32_t&        cliff,
+                    const uint32_t&        duration,
+                    const string&          memo );
+
+         /**
+          * Removes the vesting grant of `owner`, unlocking whatever has not yet vested.
+          *
+          * @param owner - the account holding the grant,
+          * @param symbolcode - the token.
+          *
+          * @pre Transaction must have the issuer authority
+          */
+         [[eosio::action]]
+         void endvest( const name& owner, const symbol_code& symbolcode );
+
          /**
           * Allows `ram_payer` to create an account `owner` with zero balance for
           * token `symbolcode` at the expense of `ram_payer`.
@@ -209,6 +477,19 @@ namespace eosio {
          [[eosio::action]]
          void open( const name& owner, const symbol_code& symbolcode, const name& ram_payer );
 
+         /**
+          * Opens zero balances of token `symbolcode` for many accounts at the expense of
+          * `ram_payer`, as repeated `open` actions would, but checking the token and its
+          * membership_mgr authority once. Owners that already have a balance row are
+          * skipped. The number of balances opened is printed.
+          *
+          * @param symbolcode - the token symbol,
+          * @param owners - up to max_open_count accounts,
+          * @param ram_payer - the account that supports the cost of this action.
+          */
+         [[eosio::action]]
+         void openmany( const symbol_code& symbolcode, const std::vector<name>& owners, const name& ram_payer );
+
          /**
           * This action is the opposite for open, it closes the account `owner`
           * for token `symbol`.
@@ -222,6 +503,23 @@ namespace eosio {
          [[eosio::action]]
          void close( const name& owner, const symbol_code& symbolcode );
 
+         /**
+          * Closes zero balances of token `symbolcode` in bounded batches, refunding their
+          * RAM to the accounts that paid for them. Owners are taken from the holders table
+          * in account name order, resuming from a cursor kept in the token's sweep row; the
+          * row is removed when a pass reaches the end of the table. Balances opened before
+          * the `holders` option was switched on are swept once added by `indexholders`.
+          *
+          * @param symbolcode - the token,
+          * @param limit - max number of holders rows to visit (for time control)
+          *
+          * @pre Transaction must have the issuer or membership_mgr authority,
+          * @pre The `holders` option of the token must be on,
+          * @pre limit must be between 1 and max_sweep_count
+          */
+         [[eosio::action]]
+         void sweep( const symbol_code& symbolcode, const uint32_t& limit );
+
          /**
           * This action freezes or unfreezes transaction processing
           * for token `symbol`.
@@ -236,17 +534,301 @@ namespace eosio {
          [[eosio::action]]
          void freeze( const symbol_code& symbolcode, const bool& freeze, const string& memo );
 
+         /**
+          * Allows `issuer` to switch an optional behavior of a token on or off.
+          * Options are kept in the token's hotconfig row. Supported options:
+          *   `settlement` - issue and retire accrue stake obligations in the settlements
+          *     table instead of sending one stake token transfer per stakes row; the
+          *     obligations are paid out by the `settle` action.
+          *   `holders` - keep the holders table (scoped on the token, ordered by balance
+          *     through the `bybalance` index) up to date on every balance change, so
+          *     holders and top holders can be listed with one range query. Holders of
+          *     balances that exist when the option is switched on are added with the
+          *     `indexholders` action. RAM for a holders row is paid by the payer of the
+          *     balance row it copies, or by the issuer for rows added by `indexholders`.
+          *   `tokenstats` - keep the tokenstats row counting holders, zero balances,
+          *     transfers and the circulating supply up to date on every balance change.
+          *     It can only be switched on before the token is approved, so that the counts
+          *     start from an empty token; switching it off removes the row. RAM for the row
+          *     is paid by the issuer.
+          *
+          * @param symbolcode - the token,
+          * @param option - name of the option,
+          * @param enabled - true to switch the option on, false to switch it off.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The config_locked_until field in the configs table must be in the past
+          */
+         [[eosio::action]]
+         void setoption( const symbol_code& symbolcode, const name& option, const bool& enabled );
+
+         /**
+          * Switches balance checkpoints of a token on or off. While on, each balance change
+          * records the new balance in the checkpoints table, at most one row per owner and
+          * epoch of `epoch` seconds, so `getsnapshot` can tell balances as of a past time.
+          * Rows more than `retain` epochs old are pruned as owners' balances change, keeping
+          * the last one before that horizon. RAM for checkpoints rows is paid by the contract,
+          * as the accounts whose balances change need not authorize the change; the epoch
+          * length and retained history are bounded so that each owner has a bounded number
+          * of rows.
+          * Switching checkpoints off erases up to max_checkpoint_erase rows; call again with
+          * a zero `epoch` until the console reports them done, as they cannot be switched
+          * back on while rows of the earlier setting remain.
+          *
+          * @param symbolcode - the token,
+          * @param epoch - seconds per epoch, at least min_checkpoint_epoch, zero to switch
+          *   checkpoints off,
+          * @param retain - epochs of history to keep, between 1 and max_checkpoint_retain.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The config_locked_until field in the configs table must be in the past,
+          * @pre No checkpoints rows of an earlier setting may remain when switching them on
+          */
+         [[eosio::action]]
+         void setcheckpt( const symbol_code& symbolcode, const uint32_t& epoch, const uint32_t& retain );
+
+         /**
+          * Switches the recent transfers table of a token on or off. While on, the last
+          * `slots` balance movements of the token (transfers, issues, retires, claims and
+          * scheduled payments) are kept in the recent table, each numbered by a sequence
+          * number and written over the oldest one, so RAM use stays constant. Indexers read
+          * new movements with one range query on the `byseq` index from the last sequence
+          * number they saw. Each call clears the table; sequence numbers continue.
+          * RAM for recent rows is paid by the contract.
+          *
+          * @param symbolcode - the token,
+          * @param slots - number of movements kept, up to max_recent_slots, zero to switch
+          *   the table off.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The config_locked_until field in the configs table must be in the past
+          */
+         [[eosio::action]]
+         void setrecent( const symbol_code& symbolcode, const uint32_t& slots );
+
+         /**
+          * Sets or clears the transfer rate limit of a token. While set, each account may send
+          * at most `max_transfers` transfers and `max_volume` tokens per `window` seconds, with
+          * unused allowance refilling steadily over the window rather than all at its end.
+          * The issuer and withdrawals by the withdrawal_mgr are exempt, as they are from freezes.
+          * Each sender has one ratebuckets row holding the times its two allowances are full
+          * again; it is brought up to date when the sender next transfers, so enforcement costs
+          * one row read and write per transfer and stale rows need no cleanup. RAM for the row
+          * is paid by the sender, by the spender of a `transferfrom` or `pullmany`, or by this
+          * contract for a payment made by `crank`.
+          *
+          * @param symbolcode - the token,
+          * @param window - seconds over which the limits apply, zero to clear the limit,
+          * @param max_transfers - transfers per window, zero for no count limit,
+          * @param max_volume - tokens sent per window, zero for no volume limit.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The config_locked_until field in the configs table must be in the past
+          */
+         [[eosio::action]]
+         void setlimit( const symbol_code& symbolcode, const uint32_t& window, const uint32_t& max_transfers,
+                        const asset& max_volume );
+
+         /**
+          * Sets the transfer fee of a token: `basis_points` / 10000 of each transfer, at most
+          * `max_fee`, paid by the sender on top of the quantity sent. The issuer, the treasury
+          * and withdrawals by the withdrawal_mgr pay no fee. Fees are not credited to the
+          * treasury directly, which would make its balance row a write hotspot shared by every
+          * transfer; they accrue in one of `shards` feeshards rows chosen by the sender, and
+          * `sweepfees` moves them to the treasury. A zero `basis_points` stops fees; the
+          * treasury stays set so that fees already accrued can still be swept. RAM for the
+          * feeshards rows is paid by the contract.
+          *
+          * @param symbolcode - the token,
+          * @param basis_points - fee in hundredths of a percent, up to 10000,
+          * @param max_fee - largest fee of one transfer, zero for no cap,
+          * @param treasury - the account fees are swept to,
+          * @param shards - number of feeshards rows, between 1 and max_fee_shards.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The config_locked_until field in the configs table must be in the past,
+          * @pre treasury must have a balance of the token
+          */
+         [[eosio::action]]
+         void setfee( const symbol_code& symbolcode, const uint16_t& basis_points, const asset& max_fee,
+                      const name& treasury, const uint32_t& shards );
+
+         /**
+          * Moves fees accrued in up to `limit` feeshards rows of a token to its treasury
+          * balance, erasing the rows. Any account may call this action; call again until the
+          * console reports no shards remaining.
+          *
+          * @param symbolcode - the token,
+          * @param limit - max number of feeshards rows swept (for time control)
+          *
+          * @pre limit must be between 1 and max_fee_shards
+          */
+         [[eosio::action]]
+         void sweepfees( const symbol_code& symbolcode, const uint32_t& limit );
+
+#if RAINBOW_STAKING
+         /**
+          * Pays out accrued stake obligations for a token from the settlements table, oldest
+          * first. Stakes and redemptions of one owner accrue as a net amount in one row per
+          * stake and escrow, and the rows of a batch are netted again per (stake token,
+          * owner, escrow), so the issuer's stakes into one escrow take a single transfer and
+          * each redeeming owner gets one. Proportional stakes and redemptions are counted in
+          * the pending amount of the escrow when they accrue, so redemptions share the escrow
+          * together with stakes that are still waiting for a settle and never add up to more
+          * than it. A row whose transfer fails, e.g. to an account that can no longer receive
+          * the stake token, is skipped by settling the rows before it and then starting after
+          * it. Any account may call this action.
+          *
+          * @param symbolcode - the token,
+          * @param first_id - the first settlements row id to pay out,
+          * @param limit - max number of settlements rows to pay out (for time control)
+          *
+          * @pre limit must be between 1 and max_settle_count
+          */
+         [[eosio::action]]
+         void settle( const symbol_code& symbolcode, const uint64_t& first_id, const uint32_t& limit );
+#endif
+
+         /**
+          * Rescales the balances of `owners` to the new precision of a token whose
+          * precision migration was started by `create`. Balances already at the new
+          * precision are skipped, so chunks may overlap or be repeated. Holder accounts
+          * cannot be enumerated on chain; callers supply them in chunks, e.g. from the
+          * table scopes listed by the chain API. With the `holders` option on, an empty
+          * `owners` instead takes the next max_migrate_count owners of the holders table,
+          * continuing where the last such call stopped. When the rescaled balances account
+          * for the whole supply, the stat and stakes rows are rescaled and the migration
+          * ends. Transfers, issue and retire of the token are paused until then. Any
+          * account may call this action.
+          *
+          * @param symbolcode - the token,
+          * @param owners - up to max_migrate_count holder accounts, or none to walk the
+          *   holders table.
+          *
+          * @pre A precision migration of the token must be in progress,
+          * @pre `owners` may be empty only if the `holders` option of the token is on
+          */
+         [[eosio::action]]
+         void migrate( const symbol_code& symbolcode, const std::vector<name>& owners );
+
+         /**
+          * Ends a precision migration of a token before `migrate` has reached every
+          * balance, e.g. when some holder accounts cannot be found. The supply not yet
+          * migrated is rescaled as a whole, and the stat and stakes rows are rescaled as
+          * when `migrate` ends it. Balances not reached are rescaled when they next change;
+          * the digits they lose at a lower precision stay in the supply.
+          *
+          * @param symbolcode - the token.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre A precision migration of the token must be in progress
+          */
+         [[eosio::action]]
+         void endmigrate( const symbol_code& symbolcode );
+
+         /**
+          * Adds the balances of `owners` to the holders table of a token with the
+          * `holders` option on, or brings their rows up to date. Owners without a
+          * balance row are skipped. Used to index balances that existed before the
+          * option was switched on, which are not added by other actions. RAM for the
+          * rows added is paid by the issuer.
+          *
+          * @param symbolcode - the token,
+          * @param owners - up to max_migrate_count holder accounts.
+          *
+          * @pre Transaction must have the issuer authority,
+          * @pre The `holders` option of the token must be on
+          */
+         [[eosio::action]]
+         void indexholders( const symbol_code& symbolcode, const std::vector<name>& owners );
+
+         struct balance_info {
+            name     owner;
+            asset    balance;
+         };
+
+         struct display_info {
+            string   name;
+            string   logo;
+            string   logo_lg;
+            string   web_link;
+            string   background;
+            string   json_meta;
+         };
+
+         struct token_info {
+            asset        supply;
+            asset        max_supply;
+            name         issuer;
+            name         membership_mgr;
+            name         withdrawal_mgr;
+            name         withdraw_to;
+            name         freeze_mgr;
+            uint32_t     flags;      // hotconfig flags: 1 allowall, 2 frozen, 4 approved, 8 settlement,
+                                     // 16 migrating, 32 holders, 64 tokenstats, 128 vesting,
+                                     // 256 checkpoints, 512 recent, 1024 ratelimit, 2048 fees
+            display_info display;
+         };
+
+         /**
+          * Returns the balances of `owners` in the tokens `symbolcodes` as the action return
+          * value; with no symbol codes, every balance of each owner. Balance rows that do not
+          * exist are left out. The action writes nothing and needs no authority, so it is meant
+          * to be run as a read-only transaction (e.g. the chain API's compute_transaction).
+          *
+          * @param owners - up to max_query_count accounts,
+          * @param symbolcodes - up to max_query_count tokens, or none for all.
+          */
+         [[eosio::action]]
+         std::vector<balance_info> getbalances( const std::vector<name>& owners,
+                                                const std::vector<symbol_code>& symbolcodes );
+
+         /**
+          * Returns supply, configuration and display metadata of the tokens `symbolcodes` as
+          * the action return value, with display strings resolved from the blobs table. Tokens
+          * that do not exist are left out. Like `getbalances`, this action writes nothing.
+          *
+          * @param symbolcodes - up to max_query_count tokens.
+          */
+         [[eosio::action]]
+         std::vector<token_info> gettokens( const std::vector<symbol_code>& symbolcodes );
+
+         /**
+          * Returns the balances of `owners` in token `symbolcode` as of `time`, from the
+          * checkpoints table, as the action return value. A balance is that at the end of
+          * the epoch containing `time`; owners whose balance has not changed since
+          * checkpoints were switched on get their current balance. Times before the
+          * retained history get the balance at its start.
+          *
+          * @param symbolcode - the token,
+          * @param time - the time of the snapshot,
+          * @param owners - up to max_query_count accounts.
+          *
+          * @pre Checkpoints of the token must be on
+          */
+         [[eosio::action]]
+         std::vector<balance_info> getsnapshot( const symbol_code& symbolcode, const time_point_sec& time,
+                                                const std::vector<name>& owners );
+
+#if RAINBOW_RESETRAM
          /**
           * This action clears a RAM table (development use only!)
+          * At most `limit` rows are erased per call; call again until the console
+          * reports the scope done. The rows erased from a scope so far, and the row the
+          * next call resumes at, are kept in the cleanups table until it is empty.
+          * Clearing displayrefs releases the blobs of the token's display; blobs still
+          * referred to by a displayrefs row are kept when clearing blobs.
           *
           * @param table - name of table
-          * @param scope - string
+          * @param scope - string; a symbol code or account name, or several separated by commas
+          *   (empty entries are ignored)
           * @param limit - max number of erasures (for time control)
           *
           * @pre Transaction must have the contract account authority 
           */
          [[eosio::action]]
          void resetram( const name& table, const string& scope, const uint32_t& limit = 10 );
+#endif
 
          static asset get_supply( const name& token_contract_account, const symbol_code& sym_code )
          {
@@ -264,19 +846,71 @@ namespace eosio {
 
          using create_action = eosio::action_wrapper<"create"_n, &token::create>;
          using approve_action = eosio::action_wrapper<"approve"_n, &token::approve>;
+#if RAINBOW_STAKING
          using setstake_action = eosio::action_wrapper<"setstake"_n, &token::setstake>;
+#endif
+#if RAINBOW_DISPLAY
          using setdisplay_action = eosio::action_wrapper<"setdisplay"_n, &token::setdisplay>;
+#endif
          using issue_action = eosio::action_wrapper<"issue"_n, &token::issue>;
+         using setdrop_action = eosio::action_wrapper<"setdrop"_n, &token::setdrop>;
+         using claim_action = eosio::action_wrapper<"claim"_n, &token::claim>;
+         using enddrop_action = eosio::action_wrapper<"enddrop"_n, &token::enddrop>;
          using retire_action = eosio::action_wrapper<"retire"_n, &token::retire>;
          using transfer_action = eosio::action_wrapper<"transfer"_n, &token::transfer>;
+         using transfers_action = eosio::action_wrapper<"transfers"_n, &token::transfers>;
+         using setallowance_action = eosio::action_wrapper<"setallowance"_n, &token::setallowance>;
+         using transferfrom_action = eosio::action_wrapper<"transferfrom"_n, &token::transferfrom>;
+         using pullmany_action = eosio::action_wrapper<"pullmany"_n, &token::pullmany>;
+         using schedule_action = eosio::action_wrapper<"schedule"_n, &token::schedule>;
+         using unschedule_action = eosio::action_wrapper<"unschedule"_n, &token::unschedule>;
+         using crank_action = eosio::action_wrapper<"crank"_n, &token::crank>;
+         using vest_action = eosio::action_wrapper<"vest"_n, &token::vest>;
+         using endvest_action = eosio::action_wrapper<"endvest"_n, &token::endvest>;
          using open_action = eosio::action_wrapper<"open"_n, &token::open>;
+         using openmany_action = eosio::action_wrapper<"openmany"_n, &token::openmany>;
          using close_action = eosio::action_wrapper<"close"_n, &token::close>;
+         using sweep_action = eosio::action_wrapper<"sweep"_n, &token::sweep>;
          using freeze_action = eosio::action_wrapper<"freeze"_n, &token::freeze>;
+         using setoption_action = eosio::action_wrapper<"setoption"_n, &token::setoption>;
+         using setcheckpt_action = eosio::action_wrapper<"setcheckpt"_n, &token::setcheckpt>;
+         using setrecent_action = eosio::action_wrapper<"setrecent"_n, &token::setrecent>;
+         using setlimit_action = eosio::action_wrapper<"setlimit"_n, &token::setlimit>;
+         using setfee_action = eosio::action_wrapper<"setfee"_n, &token::setfee>;
+         using sweepfees_action = eosio::action_wrapper<"sweepfees"_n, &token::sweepfees>;
+#if RAINBOW_STAKING
+         using settle_action = eosio::action_wrapper<"settle"_n, &token::settle>;
+#endif
+         using migrate_action = eosio::action_wrapper<"migrate"_n, &token::migrate>;
+         using endmigrate_action = eosio::action_wrapper<"endmigrate"_n, &token::endmigrate>;
+         using indexholders_action = eosio::action_wrapper<"indexholders"_n, &token::indexholders>;
+         using getbalances_action = eosio::action_wrapper<"getbalances"_n, &token::getbalances>;
+         using gettokens_action = eosio::action_wrapper<"gettokens"_n, &token::gettokens>;
+         using getsnapshot_action = eosio::action_wrapper<"getsnapshot"_n, &token::getsnapshot>;
+#if RAINBOW_RESETRAM
          using resetram_action = eosio::action_wrapper<"resetram"_n, &token::resetram>;
+#endif
       private:
          const name allowallacct = "allowallacct"_n;
          const name deletestakeacct = "deletestake"_n;
          const int max_stake_count = 8; // don't use too much cpu time to complete transaction
+         const uint32_t max_settle_count = 50; // settlements rows per settle action
+         const microseconds escrow_refresh = days( 1 ); // max age of a cached escrow balance
+         const uint32_t max_migrate_count = 100; // accounts rows rescaled per migrate action
+         const uint64_t max_drop_leaves = 1ull << 24; // claims per airdrop
+         const uint32_t max_query_count = 100; // owners or symbols per query action
+         const uint32_t max_open_count = 500; // balances opened per openmany action
+         const uint32_t max_sweep_count = 500; // holders rows visited per sweep action
+         const uint32_t max_crank_count = 100; // scheduled payments made per crank action
+         const uint32_t min_schedule_period = 3600; // seconds between payments of a recurring schedule
+         const uint32_t max_checkpoint_erase = 500; // checkpoints rows erased per setcheckpt action
+         const uint32_t min_checkpoint_epoch = 3600; // seconds per checkpoint epoch
+         const uint32_t max_checkpoint_retain = 1000; // checkpoint epochs kept per owner
+         const uint32_t max_reject_erase = 500; // rows erased per approve action rejecting a token
+         const uint32_t max_recent_slots = 1000; // recent rows per token, also bounds setrecent
+         const uint32_t max_fee_shards = 64; // feeshards rows per token, also bounds sweepfees
+         const uint32_t max_proof_length = 24; // enough for max_drop_leaves
+         static constexpr uint64_t claim_bitmap_bits = 1024; // claim flags per claimed row
 
          struct [[eosio::table]] account { // scoped on account name
             asset    balance;
@@ -303,7 +937,52 @@ namespace eosio {
             bool       approved;
          };
 
-         struct [[eosio::table]] currency_display {  // scoped on token symbol code
+         struct [[eosio::table]] hot_config {  // scoped on token symbol code
+            symbol     supply_symbol;   // includes precision
+            name       issuer;
+            name       withdrawal_mgr;
+            name       withdraw_to;
+            uint32_t   flags;           // hot_* bits below
+         };
+
+         // hot_config flags, copied from currency_config by create, approve and freeze
+         static constexpr uint32_t hot_allowall = 1u << 0;  // membership_mgr is allowallacct
+         static constexpr uint32_t hot_frozen   = 1u << 1;  // transfers_frozen
+         static constexpr uint32_t hot_approved = 1u << 2;  // approved
+         // hot_config state not derived from currency_config, preserved when the config is copied
+         static constexpr uint32_t hot_settle    = 1u << 3;  // accrue stake transfers for settle
+         static constexpr uint32_t hot_migrating = 1u << 4;  // precision migration in progress
+         static constexpr uint32_t hot_holders   = 1u << 5;  // maintain the holders table
+         static constexpr uint32_t hot_tokenstats = 1u << 6; // maintain the tokenstats row
+         static constexpr uint32_t hot_vesting   = 1u << 7;  // vestings rows may lock balances
+         static constexpr uint32_t hot_checkpoints = 1u << 8; // maintain the checkpoints table
+         static constexpr uint32_t hot_recent    = 1u << 9;  // maintain the recent table
+         static constexpr uint32_t hot_ratelimit = 1u << 10; // transfers are rate limited
+         static constexpr uint32_t hot_fees      = 1u << 11; // transfers pay a fee
+         static constexpr uint32_t hot_options   = hot_settle | hot_migrating | hot_holders | hot_tokenstats |
+                                                   hot_vesting | hot_checkpoints | hot_recent | hot_ratelimit |
+                                                   hot_fees;
+
+         struct [[eosio::table]] display_refs {  // scoped on token symbol code
+            string     name;
+            uint64_t   logo;         // blobs row ids, 0 for an empty string
+            uint64_t   logo_lg;
+            uint64_t   web_link;
+            uint64_t   background;
+            uint64_t   json_meta;
+         };
+
+         struct [[eosio::table]] blob {  // scoped on contract account
+            uint64_t    id;
+            checksum256 hash;        // sha256 of data
+            string      data;
+            uint64_t    refs;        // displayrefs fields referring to this blob
+
+            uint64_t primary_key()const { return id; };
+            checksum256 by_hash() const { return hash; };
+         };
+
+         struct [[eosio::table]] currency_display {  // scoped on token symbol code, superseded by display_refs
             string     name;
             string     logo;
             string     logo_lg;
@@ -328,25 +1007,398 @@ namespace eosio {
             }
          };
 
+         struct [[eosio::table]] escrow_stats {  // scoped on token symbol code, proportional stakes only
+            uint64_t   stake_index;
+            asset      escrowed;     // stake held by stake_to on behalf of this token
+            asset      pending;      // stake accrued for settle and not yet held by stake_to
+            time_point refreshed;    // last reconciled with the stake_to balance
+
+            uint64_t primary_key()const { return stake_index; };
+         };
+
+         struct [[eosio::table]] migration_stats {  // scoped on token symbol code
+            asset      max_supply;   // in the new precision
+            asset      migrated;     // balances rescaled so far, in the old precision
+            asset      rescaled;     // the same balances in the new precision
+            uint64_t   rows;         // accounts rows rescaled so far
+            name       next;         // first holders row of the next migrate action without owners
+         };
+
+         struct [[eosio::table]] token_aggregates {  // scoped on token symbol code, tokens with the tokenstats option only
+            uint64_t   holders;      // accounts rows with a nonzero balance
+            uint64_t   zero_rows;    // accounts rows with a zero balance
+            asset      circulating;  // supply less the issuer and withdraw_to balances, unclaimed
+                                     // airdrops and unswept fees
+            uint64_t   transfers;    // transfers, counting each entry of a batch
+         };
+
+         struct aggregate_delta { // change to one token's aggregates during an action
+            int64_t    holders = 0;
+            int64_t    zero_rows = 0;
+            int64_t    circulating = 0;
+            uint64_t   transfers = 0;
+         };
+
+         struct [[eosio::table]] airdrop {  // scoped on token symbol code
+            uint64_t    id;
+            checksum256 root;        // Merkle root of the ( index, owner, amount ) leaves
+            asset       remaining;   // issued and not yet claimed
+            uint64_t    leaves;
+
+            uint64_t primary_key()const { return id; };
+         };
+
+         struct [[eosio::table]] claim_bitmap {  // scoped on token symbol code
+            uint64_t               id;      // drop id << 32 | leaf index / claim_bitmap_bits
+            std::vector<uint64_t>  words;   // one bit per leaf index, set when claimed
+
+            uint64_t primary_key()const { return id; };
+         };
+
+         struct [[eosio::table]] holder {  // scoped on token symbol code, tokens with the holders option only
+            name       owner;
+            asset      balance;      // copy of the owner's accounts row
+
+            uint64_t primary_key()const { return owner.value; };
+            uint64_t by_balance() const { return balance.amount; };
+         };
+
+         struct [[eosio::table]] payment_schedule {  // scoped on token symbol code
+            uint64_t        id;
+            name            payer;
+            name            payee;
+            asset           quantity;
+            uint32_t        period;       // seconds between payments, 0 for a single payment
+            time_point_sec  next_due;
+            string          memo;
+
+            uint64_t primary_key()const { return id; };
+            uint64_t by_due() const { return next_due.sec_since_epoch(); };
+         };
+
+         struct [[eosio::table]] vesting {  // scoped on token symbol code
+            name            owner;
+            asset           quantity;     // granted, locked in full until start + cliff
+            time_point_sec  start;
+            uint32_t        cliff;        // seconds from start
+            uint32_t        duration;     // seconds from start until fully vested
+
+            uint64_t primary_key()const { return owner.value; };
+         };
+
+         struct [[eosio::table]] checkpoint_config {  // scoped on token symbol code, tokens with checkpoints only
+            uint32_t   epoch;        // seconds
+            uint32_t   retain;       // epochs of history kept
+         };
+
+         struct [[eosio::table]] checkpoint {  // scoped on token symbol code
+            uint64_t        id;
+            name            owner;
+            time_point_sec  epoch;        // start of the epoch the balance was last written in
+            asset           balance;      // balance at the end of that epoch
+
+            uint64_t primary_key()const { return id; };
+            uint128_t by_owner_epoch() const {
+               return (uint128_t)owner.value<<64 | epoch.sec_since_epoch();
+            }
+         };
+
+         struct [[eosio::table]] recent_head {  // scoped on token symbol code
+            uint64_t   next_seq;     // sequence number of the next movement
+            uint32_t   slots;        // recent rows kept, 0 while the table is off
+         };
+
+         struct [[eosio::table]] recent_transfer {  // scoped on token symbol code, tokens with a recent table only
+            uint64_t     slot;       // seq % slots
+            uint64_t     seq;
+            name         from;       // empty for an issue or claim, the contract for swept fees
+            name         to;         // empty for a retire
+            asset        quantity;
+            checksum256  memo_hash;  // sha256 of the memo
+
+            uint64_t primary_key()const { return slot; };
+            uint64_t by_seq() const { return seq; };
+         };
+
+         struct [[eosio::table]] rate_limit {  // scoped on token symbol code, rate limited tokens only
+            uint32_t   window;         // seconds
+            uint32_t   max_transfers;  // per window, 0 for no limit
+            asset      max_volume;     // per window, 0 for no limit
+         };
+
+         struct [[eosio::table]] rate_bucket {  // scoped on token symbol code
+            name        owner;
+            time_point  count_full;    // when the owner's transfer count allowance is full again
+            time_point  volume_full;   // when the owner's volume allowance is full again
+
+            uint64_t primary_key()const { return owner.value; };
+         };
+
+         struct [[eosio::table]] fee_config {  // scoped on token symbol code, tokens with a fee only
+            uint16_t   basis_points;   // 0 while fees are off
+            asset      max_fee;        // 0 for no cap
+            name       treasury;
+            uint32_t   shards;
+         };
+
+         struct [[eosio::table]] fee_shard {  // scoped on token symbol code
+            uint64_t   shard;          // from fee_shard_of the sender
+            asset      accrued;        // fees not yet swept to the treasury
+
+            uint64_t primary_key()const { return shard; };
+         };
+
+         struct [[eosio::table]] allowance {  // scoped on token symbol code
+            uint64_t        id;
+            name            owner;
+            name            spender;
+            asset           remaining;     // in the precision of when it was last set or used
+            time_point_sec  expiry;
+
+            uint64_t primary_key()const { return id; };
+            uint128_t by_owner_spender() const {
+               return (uint128_t)owner.value<<64 | spender.value;
+            }
+         };
+
+         struct [[eosio::table]] sweep_stats {  // scoped on token symbol code, during a sweep pass only
+            name       next;         // first holders row of the next sweep action
+            uint64_t   closed;       // zero balances closed in this pass so far
+         };
+
+         struct [[eosio::table]] cleanup_stats {  // scoped on table name
+            uint64_t   scope;
+            uint64_t   erased;       // rows erased by resetram so far
+            uint64_t   next;         // primary key of the row the next call starts at
+
+            uint64_t primary_key()const { return scope; };
+         };
+
+         struct [[eosio::table]] settlement {  // scoped on token symbol code
+            uint64_t id;
+            uint64_t stake_index;           // stakes row the obligation arose from
+            name     owner;
+            name     stake_token_contract;
+            name     stake_to;
+            asset    amount;                // > 0: owner pays escrow, < 0: escrow pays owner
+
+            uint64_t primary_key()const { return id; };
+            uint128_t by_stake_owner() const {
+               return (uint128_t)stake_index<<64 | owner.value;
+            }
+         };
+
          typedef eosio::multi_index< "accounts"_n, account > accounts;
          typedef eosio::multi_index< "stat"_n, currency_stats > stats;
          typedef eosio::singleton< "configs"_n, currency_config > configs;
          typedef eosio::multi_index< "configs"_n, currency_config >  dump_for_config;
+         typedef eosio::singleton< "hotconfig"_n, hot_config > hotconfigs;
+         typedef eosio::multi_index< "hotconfig"_n, hot_config >  dump_for_hotconfig;
          typedef eosio::singleton< "displays"_n, currency_display > displays;
          typedef eosio::multi_index< "displays"_n, currency_display >  dump_for_display;
+         typedef eosio::singleton< "displayrefs"_n, display_refs > displayrefs;
+         typedef eosio::multi_index< "displayrefs"_n, display_refs >  dump_for_displayrefs;
+         typedef eosio::multi_index
+            < "blobs"_n, blob, indexed_by
+               < "byhash"_n,
+                 const_mem_fun<blob, checksum256, &blob::by_hash >
+               >
+            > blobs;
          typedef eosio::multi_index
             < "stakes"_n, stake_stats, indexed_by
                < "staketoken"_n,
                  const_mem_fun<stake_stats, uint128_t, &stake_stats::by_secondary >
                >
             > stakes;
+         typedef eosio::multi_index< "escrows"_n, escrow_stats > escrows;
+         typedef eosio::multi_index< "cleanups"_n, cleanup_stats > cleanups;
+         typedef eosio::multi_index< "airdrops"_n, airdrop > airdrops;
+         typedef eosio::multi_index< "claimed"_n, claim_bitmap > claimed;
+         typedef eosio::singleton< "tokenstats"_n, token_aggregates > tokenstats;
+         typedef eosio::multi_index< "tokenstats"_n, token_aggregates >  dump_for_tokenstats;
+         typedef eosio::multi_index
+            < "holders"_n, holder, indexed_by
+               < "bybalance"_n,
+                 const_mem_fun<holder, uint64_t, &holder::by_balance >
+               >
+            > holders;
+         typedef eosio::multi_index
+            < "schedules"_n, payment_schedule, indexed_by
+               < "bydue"_n,
+                 const_mem_fun<payment_schedule, uint64_t, &payment_schedule::by_due >
+               >
+            > schedules;
+         typedef eosio::multi_index< "vestings"_n, vesting > vestings;
+         typedef eosio::singleton< "ckconfig"_n, checkpoint_config > ckconfigs;
+         typedef eosio::multi_index< "ckconfig"_n, checkpoint_config >  dump_for_ckconfig;
+         typedef eosio::multi_index
+            < "checkpoints"_n, checkpoint, indexed_by
+               < "ownerepoch"_n,
+                 const_mem_fun<checkpoint, uint128_t, &checkpoint::by_owner_epoch >
+               >
+            > checkpoints;
+         typedef eosio::singleton< "recenthead"_n, recent_head > recentheads;
+         typedef eosio::multi_index< "recenthead"_n, recent_head >  dump_for_recenthead;
+         typedef eosio::multi_index
+            < "recent"_n, recent_transfer, indexed_by
+               < "byseq"_n,
+                 const_mem_fun<recent_transfer, uint64_t, &recent_transfer::by_seq >
+               >
+            > recents;
+         typedef eosio::singleton< "ratelimit"_n, rate_limit > ratelimits;
+         typedef eosio::multi_index< "ratelimit"_n, rate_limit >  dump_for_ratelimit;
+         typedef eosio::multi_index< "ratebuckets"_n, rate_bucket > ratebuckets;
+         typedef eosio::singleton< "feeconfig"_n, fee_config > feeconfigs;
+         typedef eosio::multi_index< "feeconfig"_n, fee_config >  dump_for_feeconfig;
+         typedef eosio::multi_index< "feeshards"_n, fee_shard > feeshards;
+         typedef eosio::multi_index
+            < "allowances"_n, allowance, indexed_by
+               < "ownerspender"_n,
+                 const_mem_fun<allowance, uint128_t, &allowance::by_owner_spender >
+               >
+            > allowances;
+         typedef eosio::singleton< "sweep"_n, sweep_stats > sweeps;
+         typedef eosio::multi_index< "sweep"_n, sweep_stats >  dump_for_sweep;
+         typedef eosio::singleton< "migration"_n, migration_stats > migrations;
+         typedef eosio::multi_index< "migration"_n, migration_stats >  dump_for_migration;
+         typedef eosio::multi_index
+            < "settlements"_n, settlement, indexed_by
+               < "stakeowner"_n,
+                 const_mem_fun<settlement, uint128_t, &settlement::by_stake_owner >
+               >
+            > settlements;
+
+         struct token_state { // stats and config of one token, read once per action
+            currency_stats   st;
+            currency_config  cf;
+         };
+
+         struct pending_balance { // running balance of one accounts row during an action
+            accounts::const_iterator row;
+            asset                    balance;
+            int64_t                  original;
+            bool                     exists;
+            name                     ram_payer;
+            int64_t                  locked;      // unvested amount, -1 until looked up
+         };
+
+         struct pending_bucket { // rate limit state of one sender during an action
+            ratebuckets::const_iterator row;
+            rate_bucket                 bucket;
+            name                        ram_payer;   // of a new row
+         };
+
+         struct pending_allowance { // remaining allowance of one (owner, spender) pair during an action
+            uint64_t  id;
+            asset     remaining;
+         };
+
+         /**
+          * Action-scoped cache of accounts rows. Each (owner, symbol) row is found once;
+          * debits and credits apply to the cached balance and `flush` writes back only
+          * the rows that changed, reusing the iterator from the first lookup. Flush also
+          * copies them to the holders table, updates the tokenstats row, writes balance
+          * checkpoints, appends recorded movements to the recent table of tokens that
+          * keep them, writes the rate limit buckets charged and adds the fees charged by
+          * `send` and `try_send` to their shards and writes the allowances drawn on by
+          * `spend`. `send` applies the freeze, rate limit and fee rules of a sender, which
+          * do not bind the issuer, and returns the fee to take on top of the quantity;
+          * `try_send` also checks the sender can afford both, and refuses a transfer that
+          * fails, charging nothing, where `send` fails the action.
+          */
+         class balance_ledger {
+         public:
+            explicit balance_ledger( const name& self ) : _self( self ) {}
+
+            pending_balance& get( const name& owner, const symbol& sym );
+            int64_t locked( const name& owner, const symbol& sym );
+            void sub( const name& owner, const asset& value );
+            void add( const name& owner, const asset& value, const name& ram_payer );
+            void flush();
+            void set_config( uint64_t sym_code_raw, const hot_config& hc ) { _configs[sym_code_raw] = hc; }
+            void count_transfer( uint64_t sym_code_raw );
+            void record( const name& from, const name& to, const asset& quantity, const string& memo );
+            asset send( const name& from, const asset& quantity, const name& ram_payer );
+            std::optional<asset> try_send( const name& from, const asset& quantity, const name& ram_payer );
+            void spend( const name& owner, const name& spender, const asset& quantity );
+
+         private:
+            const hot_config& config( uint64_t sym_code_raw );
+            const checkpoint_config& checkpoint_settings( uint64_t sym_code_raw );
+            const char* charge_sender( const name& from, const asset& quantity, const name& ram_payer,
+                                       int64_t available, asset& fee );
+            const char* charge_limit( const name& owner, const asset& quantity, const name& ram_payer );
+            asset fee_of( const name& owner, const asset& quantity );
+            void accrue_fee( const name& owner, const asset& fee );
+            void write_recent();
+            void write_buckets();
+            void write_fees();
+            void write_allowances();
+
+            name                                                      _self;
+            std::map<uint64_t, hot_config>                            _configs;
+            std::map<uint64_t, aggregate_delta>                       _deltas;
+            std::map<uint64_t, checkpoint_config>                     _checkpoint_configs;
+            std::vector<recent_transfer>                              _recent;
+            std::map<uint64_t, accounts>                              _tables;
+            std::map<std::pair<uint64_t, uint64_t>, pending_balance>  _balances;
+            std::map<uint64_t, rate_limit>                            _rate_limits;
+            std::map<uint64_t, ratebuckets>                           _bucket_tables;
+            std::map<std::pair<uint64_t, uint64_t>, pending_bucket>   _buckets;
+            std::map<uint64_t, fee_config>                            _fee_configs;
+            std::map<std::pair<uint64_t, uint64_t>, asset>            _fees;          // by (symbol, shard)
+            std::map<uint64_t, allowances>                            _allowance_tables;
+            std::map<std::tuple<uint64_t, uint64_t, uint64_t>, pending_allowance>  _allowances;  // by (symbol, owner, spender)
+         };
 
-         void sub_balance( const name& owner, const asset& value );
-         void add_balance( const name& owner, const asset& value, const name& ram_payer );
+         token_state get_token_state( uint64_t sym_code_raw ) const;
+         hot_config get_hot_config( uint64_t sym_code_raw ) const;
+         hot_config make_hot_config( const currency_stats& st, const currency_config& cf ) const;
+         void set_hot_config( const currency_stats& st, const currency_config& cf, const name& ram_payer,
+                              uint32_t options = 0 );
+         static void write_hot_config( hotconfigs& hottable, const hot_config& hc, const name& ram_payer );
+         static uint32_t hot_flags( const name& self, uint64_t sym_code_raw );
+         static void update_aggregates( const name& self, uint64_t sym_code_raw, const aggregate_delta& delta );
+         void reset_circulating( const symbol_code& symbolcode );
+         static void index_holder( const name& self, const name& owner, const asset& balance, const name& ram_payer );
+         static void unindex_holder( const name& self, const name& owner, const symbol_code& symbolcode );
+         static void write_checkpoint( const name& self, const name& owner, int64_t before, const asset& balance,
+                                       const checkpoint_config& ck );
+         name add_supply( const asset& quantity, const string& memo );
+         uint64_t add_blob( const string& data, const name& payer );
+         void release_blob( uint64_t id );
+         void release_display( uint64_t sym_code_raw );
+         display_info get_display( uint64_t sym_code_raw ) const;
+         static checksum256 hash_pair( const checksum256& a, const checksum256& b );
+         uint32_t open_balances( const symbol_code& symbolcode, const std::vector<name>& owners,
+                                 const name& ram_payer );
+         void sub_balance( const name& owner, const asset& value, const string& memo );
+         void pull( balance_ledger& ledger, const hot_config& hc, const name& spender, const transfer_args& t );
+         void add_balance( const name& owner, const asset& value, const name& ram_payer, const string& memo );
          void stake_all( const name& owner, const asset& quantity );
-         void unstake_all( const name& owner, const asset& quantity );
+         void unstake_all( const name& owner, const asset& quantity, const asset& supply );
          void stake_one( const stake_stats& sk, const name& owner, const asset& quantity );
-         void unstake_one( const stake_stats& sk, const name& owner, const asset& quantity );
+         void unstake_one( const stake_stats& sk, const name& owner, const asset& quantity,
+                           const asset& supply );
+         asset stake_amount( const stake_stats& sk, const asset& quantity ) const;
+         asset proportional_amount( escrows& escrowtable, const stake_stats& sk,
+                                    const asset& quantity, const asset& supply );
+         escrows::const_iterator escrow_row( escrows& escrowtable, const stake_stats& sk, bool refresh );
+         void move_escrow( escrows& escrowtable, const stake_stats& sk, const asset& delta, bool settled = true );
+         void reset_escrow( const stake_stats& sk );
+         bool settlement_mode( const symbol& sym ) const;
+         static asset rescale( const asset& value, const symbol& sym );
+         template<typename Table>
+         static bool erase_rows( Table&& table, uint32_t& limit );
+         template<typename Table>
+         static bool erase_rows( Table&& table, uint64_t& next, uint32_t& limit );
+         static int64_t locked_amount( const vesting& v, const time_point_sec& now );
+         static uint64_t fee_shard_of( const name& owner, uint32_t shards );
+         void finish_migration( const symbol_code& symbolcode, const migration_stats& mg );
+#if RAINBOW_RESETRAM
+         uint32_t reset_scope( const name& table, const string& scope, uint32_t limit );
+#endif
+         void accrue_stake( const stake_stats& sk, const name& owner, const asset& stake_quantity );
  
    };
 
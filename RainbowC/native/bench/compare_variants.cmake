@@ -0,0 +1,127 @@
+# Compares the feature variants of the contract: size of the compiled contract object and,
+# for actions every variant has, CPU time and db operations per action.
+#
+#   cmake -DVARIANTS=full,lite -Dfull_OBJECT=... -Dfull_BENCH=... -Dlite_OBJECT=... \
+#         -Dlite_BENCH=... [-DMIN_TIME=0.5] -P compare_variants.cmake
+#
+# The first variant is the baseline. Run by the `compare_variants` target of the native build.
+
+cmake_minimum_required( VERSION 3.10 )
+
+if( NOT MIN_TIME )
+   set( MIN_TIME 0.5 )
+endif()
+set( FILTER "^BM_(create|issue/0|transfer|transfers/16|retire/0|openmany/100|claim/1024)$" )
+string( REPLACE "," ";" VARIANTS "${VARIANTS}" )
+list( GET VARIANTS 0 baseline )
+
+# runs the benchmarks of `variant`, setting <variant>_<benchmark>_cpu and _db for each
+macro( run_variant variant )
+   execute_process( COMMAND ${${variant}_BENCH} --benchmark_filter=${FILTER}
+                            --benchmark_min_time=${MIN_TIME} --benchmark_format=csv
+                    OUTPUT_VARIABLE csv ERROR_QUIET RESULT_VARIABLE status )
+   if( NOT status EQUAL 0 )
+      message( FATAL_ERROR "${${variant}_BENCH} failed: ${status}" )
+   endif()
+   string( REPLACE "\n" ";" lines "${csv}" )
+   set( columns "" )
+   foreach( line ${lines} )
+      string( REPLACE "," ";" fields "${line}" )
+      if( line MATCHES "^name," )
+         string( REPLACE "\"" "" columns "${fields}" )
+      elseif( line MATCHES "^\"BM_" AND columns )
+         list( GET fields 0 bench )
+         string( REPLACE "\"" "" bench "${bench}" )
+         list( FIND columns cpu_time cpu_column )
+         list( GET fields ${cpu_column} cpu )
+         set( db 0 )
+         foreach( counter db_reads db_writes )
+            list( FIND columns ${counter} column )
+            if( column GREATER -1 )
+               list( GET fields ${column} ops )
+               string( REGEX REPLACE "\\..*" "" ops "${ops}" )
+               if( ops MATCHES "^[0-9]+$" )
+                  math( EXPR db "${db} + ${ops}" )
+               endif()
+            endif()
+         endforeach()
+         string( REGEX REPLACE "\\..*" "" cpu "${cpu}" )
+         set( ${variant}_${bench}_cpu ${cpu} )
+         set( ${variant}_${bench}_db ${db} )
+         list( APPEND benches ${bench} )
+      endif()
+   endforeach()
+endmacro()
+
+# appends `text` to `row`, right-aligned in `width` columns
+macro( append_column row text width )
+   string( LENGTH "${text}" length )
+   math( EXPR padding "${width} - ${length}" )
+   if( padding GREATER 0 )
+      string( REPEAT " " ${padding} pad )
+      string( APPEND ${row} "${pad}" )
+   endif()
+   string( APPEND ${row} "${text}" )
+endmacro()
+
+# `value` against `base` as a signed percentage
+function( percent_of value base out )
+   if( base GREATER 0 )
+      math( EXPR change "(${value} - ${base}) * 100 / ${base}" )
+      if( change GREATER -1 )
+         set( change "+${change}" )
+      endif()
+      set( ${out} "${change}%" PARENT_SCOPE )
+   else()
+      set( ${out} "" PARENT_SCOPE )
+   endif()
+endfunction()
+
+set( benches "" )
+foreach( variant ${VARIANTS} )
+   run_variant( ${variant} )
+endforeach()
+list( REMOVE_DUPLICATES benches )
+
+set( header "" )
+append_column( header "variant" 12 )
+append_column( header "object bytes" 16 )
+message( "${header}" )
+file( SIZE "${${baseline}_OBJECT}" base_size )
+foreach( variant ${VARIANTS} )
+   file( SIZE "${${variant}_OBJECT}" size )
+   percent_of( ${size} ${base_size} change )
+   set( row "" )
+   append_column( row "${variant}" 12 )
+   append_column( row "${size}" 16 )
+   if( NOT variant STREQUAL baseline )
+      append_column( row "${change}" 8 )
+   endif()
+   message( "${row}" )
+endforeach()
+
+message( "\ncpu ns / db ops per action" )
+set( header "" )
+append_column( header "benchmark" 20 )
+foreach( variant ${VARIANTS} )
+   append_column( header "${variant}" 20 )
+endforeach()
+message( "${header}" )
+foreach( bench ${benches} )
+   set( row "" )
+   append_column( row "${bench}" 20 )
+   foreach( variant ${VARIANTS} )
+      set( cpu "${${variant}_${bench}_cpu}" )
+      if( cpu STREQUAL "" )
+         append_column( row "-" 20 )
+         continue()
+      endif()
+      set( cell "${cpu} / ${${variant}_${bench}_db}" )
+      if( NOT variant STREQUAL baseline AND NOT "${${baseline}_${bench}_cpu}" STREQUAL "" )
+         percent_of( ${cpu} ${${baseline}_${bench}_cpu} change )
+         set( cell "${cell} ${change}" )
+      endif()
+      append_column( row "${cell}" 20 )
+   endforeach()
+   message( "${row}" )
+endforeach()
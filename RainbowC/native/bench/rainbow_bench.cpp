@@ -0,0 +1,582 @@
+/**
+ *  Per-action benchmarks for the rainbow contract, run natively against the
+ *  in-memory chain stand-in. Every benchmark starts from a fresh chain, so the
+ *  numbers are reproducible on any host without nodeos or network access.
+ *
+ *  A benchmarked action that fails its checks aborts the run with a non-zero
+ *  exit code, which keeps the suite usable as a CI smoke test.
+ *
+ *  With RAINBOW_INSTRUMENT each benchmark also reports the db operations, RAM bytes
+ *  and inline actions of its last measured action as counters; `--report` prints the
+ *  full per-table breakdown as well.
+ *
+ *  The suite builds once per contract variant (rainbow_bench, rainbow_bench_lite, ...);
+ *  benchmarks of features compiled out of a variant are left out of it.
+ */
+#include <rainbow.hpp>
+#include <chain.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace eosio;
+
+namespace {
+
+   const name self           = "rainbowtoken"_n;
+   const name issuer         = "issuer"_n;
+   const name alice          = "alice"_n;
+   const name bob            = "bob"_n;
+   const name escrow         = "escrow"_n;
+   const name stake_contract = "stake.token"_n;
+
+   const symbol token_sym( "RBW", 4 );
+
+   bool print_reports = false;
+   std::set<std::string> reported; // benchmarks run several times while sizing iterations
+
+   /// distinct symbol codes for repeated `create` calls: A, B, ... Z, BA, BB, ...
+   symbol_code nth_code( uint64_t n ) {
+      std::string s;
+      do {
+         s.insert( s.begin(), char('A' + n % 26) );
+         n /= 26;
+      } while( n > 0 );
+      return symbol_code( s );
+   }
+
+   /// distinct account names: holder.a, holder.b, ...
+   name nth_holder( uint64_t n ) {
+      std::string s = nth_code( n ).to_string();
+      std::transform( s.begin(), s.end(), s.begin(), ::tolower );
+      return name( "holder." + s );
+   }
+
+#if RAINBOW_STAKING
+   symbol stake_sym( uint32_t i ) {
+      return symbol( symbol_code( std::string( "STK" ) + char('A' + i) ), 4 );
+   }
+#endif
+
+   /**
+    * A chain with the rainbow contract deployed and the usual accounts created.
+    * `setup_token` creates and approves RBW with `stake_count` (optionally proportional) staking relationships
+    * and issues an initial supply to the issuer.
+    */
+   struct harness {
+      native::chain c;
+      token         tk{ self, self, datastream<const char*>( nullptr, 0 ) };
+
+      harness() {
+         c.make_current();
+         for( auto n : { self, issuer, alice, bob, escrow, stake_contract } ) {
+            c.create_account( n );
+         }
+      }
+
+      native::action_result last;
+
+      template<typename F>
+      void run( std::vector<name> auths, F&& fn ) {
+         last = c.push( self, std::move( auths ), std::forward<F>( fn ) );
+         if( !last.ok ) {
+            std::fprintf( stderr, "benchmarked action failed: %s\n", last.error.c_str() );
+            std::exit( EXIT_FAILURE );
+         }
+      }
+
+      /// attaches the resource counts of the last action to the benchmark results
+      void report( benchmark::State& state, const std::string& label ) const {
+         const auto& s = last.stats;
+         state.counters["db_reads"]  = s.count( native::db_op::find ) + s.count( native::db_op::get )
+                                       + s.count( native::db_op::next );
+         state.counters["db_writes"] = s.count( native::db_op::modify ) + s.count( native::db_op::emplace )
+                                       + s.count( native::db_op::erase );
+         state.counters["ram_bytes"] = double( s.ram_bytes() );
+         state.counters["inlines"]   = s.inline_count();
+         if( print_reports && reported.insert( label ).second ) {
+            std::fprintf( stderr, "--- %s\n%s", label.c_str(), s.report().c_str() );
+         }
+      }
+
+      void create( const symbol& sym ) {
+         run( { issuer }, [&]{
+            tk.create( issuer, asset( int64_t(1) << 61, sym ), "allowallacct"_n,
+                       issuer, issuer, issuer, "", "" );
+         });
+      }
+
+      /// stake_count is always 0 where staking is compiled out; see stake_counts
+      void setup_token( [[maybe_unused]] uint32_t stake_count, [[maybe_unused]] bool proportional = false ) {
+         create( token_sym );
+         run( { self }, [&]{ tk.approve( token_sym.code(), false ); } );
+         c.advance( eosio::seconds( 1 ) ); // config lock defaults to the creation time
+#if RAINBOW_STAKING
+         for( uint32_t i = 0; i < stake_count; ++i ) {
+            auto ss = stake_sym( i );
+            c.put_row( stake_contract, issuer.value, "accounts"_n, ss.code().raw(),
+                       asset( 0, ss ), issuer );
+            run( { issuer }, [&]{
+               tk.setstake( issuer, asset( 10000, token_sym ), asset( 20000, ss ),
+                            stake_contract, escrow, false, proportional, "" );
+            });
+         }
+#endif
+         run( { issuer }, [&]{ tk.issue( asset( int64_t(1) << 60, token_sym ), "" ); } );
+      }
+
+      /// sends alice and bob 100 RBW each from the issuer
+      void fund_pair() {
+         for( auto owner : { alice, bob } ) {
+            run( { issuer }, [&]{ tk.transfer( issuer, owner, asset( 1000000, token_sym ), "" ); } );
+         }
+      }
+   };
+
+   /// stake counts to run with: 0 to 8, or only 0 when staking is compiled out
+   void stake_counts( benchmark::internal::Benchmark* b ) {
+      b->DenseRange( 0, token::with_staking ? 8 : 0 );
+   }
+
+   void BM_create( benchmark::State& state ) {
+      harness h;
+      uint64_t n = 0;
+      for( auto _ : state ) {
+         h.create( symbol( nth_code( n++ ), 4 ) );
+      }
+      h.report( state, "create" );
+   }
+   BENCHMARK( BM_create );
+
+   void BM_issue( benchmark::State& state ) {
+      harness h;
+      h.setup_token( state.range( 0 ) );
+      for( auto _ : state ) {
+         h.run( { issuer }, [&]{ h.tk.issue( asset( 10000, token_sym ), "" ); } );
+      }
+      h.report( state, "issue/" + std::to_string( state.range( 0 ) ) );
+   }
+   BENCHMARK( BM_issue )->Apply( stake_counts );
+
+#if RAINBOW_STAKING
+   void BM_issue_settled( benchmark::State& state ) {
+      harness h;
+      h.setup_token( state.range( 0 ) );
+      h.run( { issuer }, [&]{ h.tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+      for( auto _ : state ) {
+         h.run( { issuer }, [&]{ h.tk.issue( asset( 10000, token_sym ), "" ); } );
+      }
+      h.report( state, "issue_settled/" + std::to_string( state.range( 0 ) ) );
+   }
+   BENCHMARK( BM_issue_settled )->Arg( 1 )->Arg( 8 );
+
+   void BM_settle( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 8 );
+      h.run( { issuer }, [&]{ h.tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+      for( auto _ : state ) {
+         state.PauseTiming();
+         h.run( { issuer }, [&]{ h.tk.issue( asset( 10000, token_sym ), "" ); } );
+         state.ResumeTiming();
+         h.run( {}, [&]{ h.tk.settle( token_sym.code(), 0, 8 ); } );
+      }
+      h.report( state, "settle" );
+   }
+   BENCHMARK( BM_settle );
+#endif
+
+   checksum256 drop_leaf( uint64_t index, name owner, const asset& amount ) {
+      char leaf[32];
+      datastream<char*> ds( leaf, sizeof(leaf) );
+      ds << index << owner << amount;
+      return sha256( leaf, sizeof(leaf) );
+   }
+
+   checksum256 drop_parent( const checksum256& a, const checksum256& b ) {
+      auto lo = std::min( a, b ).extract_as_byte_array();
+      auto hi = std::max( a, b ).extract_as_byte_array();
+      char buf[64];
+      std::copy( lo.begin(), lo.end(), buf );
+      std::copy( hi.begin(), hi.end(), buf + 32 );
+      return sha256( buf, sizeof(buf) );
+   }
+
+   /// Merkle tree levels, leaf level first, over `leaves` claims of one token unit each by alice
+   std::vector<std::vector<checksum256>> drop_tree( uint64_t leaves ) {
+      std::vector<std::vector<checksum256>> levels( 1 );
+      for( uint64_t i = 0; i < leaves; ++i ) {
+         levels[0].push_back( drop_leaf( i, alice, asset( 1, token_sym ) ) );
+      }
+      while( levels.back().size() > 1 ) {
+         const auto& below = levels.back();
+         std::vector<checksum256> level;
+         for( size_t i = 0; i < below.size(); i += 2 ) {
+            level.push_back( i + 1 < below.size() ? drop_parent( below[i], below[i+1] ) : below[i] );
+         }
+         levels.push_back( std::move( level ) );
+      }
+      return levels;
+   }
+
+   void BM_claim( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const uint64_t leaves = state.range( 0 );
+      auto tree = drop_tree( leaves );
+      uint64_t drop_id = 0;
+      uint64_t index = 0;
+      h.run( { issuer }, [&]{ h.tk.setdrop( asset( leaves, token_sym ), tree.back()[0], leaves, "" ); } );
+      for( auto _ : state ) {
+         state.PauseTiming();
+         if( index == leaves ) {
+            h.run( { issuer }, [&]{ h.tk.setdrop( asset( leaves, token_sym ), tree.back()[0], leaves, "" ); } );
+            drop_id++;
+            index = 0;
+         }
+         std::vector<checksum256> proof;
+         for( size_t level = 0, i = index; level + 1 < tree.size(); ++level, i /= 2 ) {
+            if( (i ^ 1) < tree[level].size() ) {
+               proof.push_back( tree[level][i ^ 1] );
+            }
+         }
+         state.ResumeTiming();
+         h.run( { alice }, [&]{
+            h.tk.claim( token_sym.code(), drop_id, index, alice, asset( 1, token_sym ), proof );
+         });
+         index++;
+      }
+      h.report( state, "claim/" + std::to_string( leaves ) );
+   }
+   BENCHMARK( BM_claim )->Arg( 1024 )->Arg( 65536 );
+
+   /**
+    * Times transfers of `amount` between alice and bob, alternating direction, and reports them
+    * under `label`. `between`, if given, runs untimed after each transfer with the number made so far.
+    */
+   void transfer_back_and_forth( harness& h, benchmark::State& state, const std::string& label,
+                                 int64_t amount = 1, const std::string& memo = "",
+                                 const std::function<void( uint64_t )>& between = nullptr ) {
+      uint64_t n = 0;
+      for( auto _ : state ) {
+         name from = n % 2 ? bob : alice;
+         name to   = n % 2 ? alice : bob;
+         h.run( { from }, [&]{ h.tk.transfer( from, to, asset( amount, token_sym ), memo ); } );
+         n++;
+         if( between ) {
+            state.PauseTiming();
+            between( n );
+            state.ResumeTiming();
+         }
+      }
+      h.report( state, label );
+   }
+
+   void BM_transfer( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.fund_pair();
+      transfer_back_and_forth( h, state, "transfer" );
+   }
+   BENCHMARK( BM_transfer );
+
+   void BM_transfer_holders( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setoption( token_sym.code(), "holders"_n, true ); } );
+      h.fund_pair();
+      transfer_back_and_forth( h, state, "transfer_holders" );
+   }
+   BENCHMARK( BM_transfer_holders );
+
+   void BM_transfer_vesting( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const eosio::time_point_sec start = eosio::current_time_point();
+      h.run( { issuer }, [&]{ h.tk.vest( alice, asset( 1000000, token_sym ), start, 0, 1000000, "" ); } );
+      h.run( { issuer }, [&]{ h.tk.vest( bob, asset( 1000000, token_sym ), start, 0, 1000000, "" ); } );
+      h.c.advance( eosio::seconds( 500000 ) );
+      transfer_back_and_forth( h, state, "transfer_vesting" );
+   }
+   BENCHMARK( BM_transfer_vesting );
+
+   void BM_transfer_checkpoints( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setcheckpt( token_sym.code(), 3600, 10 ); } );
+      h.fund_pair();
+      // two transfers per epoch, so rows are both added and rewritten
+      transfer_back_and_forth( h, state, "transfer_checkpoints", 1, "", [&]( uint64_t n ) {
+         if( n % 2 ) {
+            h.c.advance( eosio::hours( 1 ) );
+         }
+      });
+   }
+   BENCHMARK( BM_transfer_checkpoints );
+
+   void BM_transfer_recent( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setrecent( token_sym.code(), 100 ); } );
+      h.fund_pair();
+      transfer_back_and_forth( h, state, "transfer_recent", 1, "payment" );
+   }
+   BENCHMARK( BM_transfer_recent );
+
+   void BM_transfer_ratelimit( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setlimit( token_sym.code(), 60, 1000, asset( 100000000, token_sym ) ); } );
+      h.fund_pair();
+      // stay within the limit however many iterations run
+      transfer_back_and_forth( h, state, "transfer_ratelimit", 1, "", [&]( uint64_t ) {
+         h.c.advance( eosio::seconds( 1 ) );
+      });
+   }
+   BENCHMARK( BM_transfer_ratelimit );
+
+   void BM_transfer_fees( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setfee( token_sym.code(), 10, asset( 1, token_sym ), issuer, 16 ); } );
+      h.fund_pair();
+      transfer_back_and_forth( h, state, "transfer_fees", 1000 );
+   }
+   BENCHMARK( BM_transfer_fees );
+
+   void BM_transfers( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      std::vector<token::transfer_args> batch;
+      for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+         batch.push_back( { issuer, i % 2 ? alice : bob, asset( 1, token_sym ), "" } );
+      }
+      for( auto _ : state ) {
+         h.run( { issuer }, [&]{ h.tk.transfers( batch ); } );
+      }
+      h.report( state, "transfers/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_transfers )->Arg( 1 )->Arg( 16 )->Arg( 128 );
+
+   void BM_transferfrom( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const time_point_sec expiry = current_time_point() + days( 365 );
+      h.run( { issuer }, [&]{ h.tk.transfer( issuer, alice, asset( 1000000, token_sym ), "" ); } );
+      h.run( { alice }, [&]{ h.tk.setallowance( alice, escrow, asset( 1000000, token_sym ), expiry ); } );
+      for( auto _ : state ) {
+         h.run( { escrow }, [&]{ h.tk.transferfrom( escrow, alice, bob, asset( 1, token_sym ), "" ); } );
+      }
+      h.report( state, "transferfrom" );
+   }
+   BENCHMARK( BM_transferfrom );
+
+   /// one spender pulling from `range(0)` owners per action
+   void BM_pullmany( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const time_point_sec expiry = current_time_point() + days( 365 );
+      std::vector<token::transfer_args> batch;
+      for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+         name owner = nth_holder( i );
+         h.c.create_account( owner );
+         h.run( { issuer }, [&]{ h.tk.transfer( issuer, owner, asset( 1000000, token_sym ), "" ); } );
+         h.run( { owner }, [&]{ h.tk.setallowance( owner, escrow, asset( 1000000, token_sym ), expiry ); } );
+         batch.push_back( { owner, bob, asset( 1, token_sym ), "" } );
+      }
+      for( auto _ : state ) {
+         h.run( { escrow }, [&]{ h.tk.pullmany( escrow, batch ); } );
+      }
+      h.report( state, "pullmany/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_pullmany )->Arg( 1 )->Arg( 16 )->Arg( 128 );
+
+   void BM_retire( benchmark::State& state ) {
+      harness h;
+      h.setup_token( state.range( 0 ) );
+      for( auto _ : state ) {
+         h.run( { issuer }, [&]{ h.tk.retire( issuer, asset( 10000, token_sym ), "" ); } );
+      }
+      h.report( state, "retire/" + std::to_string( state.range( 0 ) ) );
+   }
+   BENCHMARK( BM_retire )->Apply( stake_counts );
+
+#if RAINBOW_STAKING
+   void BM_retire_proportional( benchmark::State& state ) {
+      harness h;
+      h.setup_token( state.range( 0 ), true );
+      for( auto _ : state ) {
+         h.run( { issuer }, [&]{ h.tk.retire( issuer, asset( 10000, token_sym ), "" ); } );
+      }
+      h.report( state, "retire_proportional/" + std::to_string( state.range( 0 ) ) );
+   }
+   BENCHMARK( BM_retire_proportional )->Arg( 1 )->Arg( 8 );
+#endif
+
+#if RAINBOW_DISPLAY
+   void BM_setdisplay( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const symbol other( "RBX", 4 );
+      h.create( other );
+      const std::string logo( 200, 'l' ), background( 200, 'b' ), json( 1000, 'j' );
+      bool flip = false;
+      for( auto _ : state ) {
+         // both tokens share the logo, background and json_meta blobs
+         auto code = flip ? other.code() : token_sym.code();
+         h.run( { issuer }, [&]{
+            h.tk.setdisplay( issuer, code, "rainbow", logo, "", flip ? "https://x" : "https://r", background, json );
+         });
+         flip = !flip;
+      }
+      h.report( state, "setdisplay" );
+   }
+   BENCHMARK( BM_setdisplay );
+#endif
+
+   void BM_openmany( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      uint64_t n = 0;
+      for( auto _ : state ) {
+         state.PauseTiming();
+         std::vector<name> owners;
+         for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+            owners.push_back( nth_holder( n++ ) );
+            h.c.create_account( owners.back() );
+         }
+         state.ResumeTiming();
+         h.run( { issuer }, [&]{ h.tk.openmany( token_sym.code(), owners, issuer ); } );
+      }
+      h.report( state, "openmany/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_openmany )->Arg( 100 )->Arg( 500 );
+
+   void BM_sweep( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      h.run( { issuer }, [&]{ h.tk.setoption( token_sym.code(), "holders"_n, true ); } );
+      uint64_t n = 0;
+      for( auto _ : state ) {
+         state.PauseTiming();
+         std::vector<name> owners;
+         for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+            owners.push_back( nth_holder( n++ ) );
+            h.c.create_account( owners.back() );
+         }
+         h.run( { issuer }, [&]{ h.tk.openmany( token_sym.code(), owners, issuer ); } );
+         state.ResumeTiming();
+         h.run( { issuer }, [&]{ h.tk.sweep( token_sym.code(), state.range( 0 ) + 1 ); } );
+      }
+      h.report( state, "sweep/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_sweep )->Arg( 100 );
+
+   void BM_crank( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      const eosio::time_point_sec due = eosio::current_time_point();
+      for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+         auto payee = nth_holder( i );
+         h.c.create_account( payee );
+         h.run( { issuer }, [&]{ h.tk.schedule( issuer, payee, asset( 100, token_sym ), 3600, due, "" ); } );
+      }
+      for( auto _ : state ) {
+         h.run( {}, [&]{ h.tk.crank( token_sym.code(), state.range( 0 ) ); } );
+         state.PauseTiming();
+         h.c.advance( eosio::hours( 1 ) );
+         state.ResumeTiming();
+      }
+      h.report( state, "crank/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_crank )->Arg( 100 );
+
+   void BM_getbalances( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      std::vector<name> owners;
+      for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+         owners.push_back( nth_holder( i ) );
+         h.c.create_account( owners.back() );
+         h.run( { issuer }, [&]{ h.tk.transfer( issuer, owners.back(), asset( 10000, token_sym ), "" ); } );
+      }
+      for( auto _ : state ) {
+         h.run( {}, [&]{ benchmark::DoNotOptimize( h.tk.getbalances( owners, { token_sym.code() } ) ); } );
+      }
+      h.report( state, "getbalances/" + std::to_string( state.range( 0 ) ) );
+      state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+   }
+   BENCHMARK( BM_getbalances )->Arg( 10 )->Arg( 100 );
+
+#if RAINBOW_RESETRAM
+   void BM_resetram( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      for( auto _ : state ) {
+         state.PauseTiming();
+         h.run( { alice }, [&]{ h.tk.open( alice, token_sym.code(), alice ); } );
+         state.ResumeTiming();
+         h.run( { self }, [&]{ h.tk.resetram( "accounts"_n, "alice", 10 ); } );
+      }
+      h.report( state, "resetram" );
+   }
+   BENCHMARK( BM_resetram );
+#endif
+
+   void BM_migrate( benchmark::State& state ) {
+      harness h;
+      h.setup_token( 0 );
+      // leave room to rescale supply and maximum to a higher precision
+      h.run( { issuer }, [&]{ h.tk.retire( issuer, asset( (int64_t(1) << 60) - (int64_t(1) << 40), token_sym ), "" ); } );
+      std::vector<name> holders;
+      for( int64_t i = 0; i < state.range( 0 ); ++i ) {
+         holders.push_back( nth_holder( i ) );
+         h.c.create_account( holders.back() );
+         h.run( { issuer }, [&]{ h.tk.transfer( issuer, holders.back(), asset( 10000, token_sym ), "" ); } );
+      }
+      holders.push_back( issuer );
+      uint8_t precision = token_sym.precision();
+      for( auto _ : state ) {
+         state.PauseTiming();
+         precision = precision == 4 ? 5 : 4;
+         symbol sym( token_sym.code(), precision );
+         h.c.advance( eosio::seconds( 1 ) );
+         h.run( { issuer }, [&]{
+            h.tk.create( issuer, asset( int64_t(1) << 50, sym ), "allowallacct"_n, issuer, issuer, issuer, "", "" );
+         });
+         state.ResumeTiming();
+         h.run( {}, [&]{ h.tk.migrate( token_sym.code(), holders ); } );
+      }
+      h.report( state, "migrate/" + std::to_string( state.range( 0 ) ) );
+   }
+   BENCHMARK( BM_migrate )->Arg( 10 )->Arg( 99 );
+
+} // namespace
+
+int main( int argc, char** argv ) {
+   for( int i = 1; i < argc; ++i ) {
+      if( std::string( argv[i] ) == "--report" ) {
+         print_reports = true;
+         std::copy( argv + i + 1, argv + argc, argv + i );
+         --argc;
+         break;
+      }
+   }
+   benchmark::Initialize( &argc, argv );
+   if( benchmark::ReportUnrecognizedArguments( argc, argv ) ) return 1;
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+   return 0;
+}
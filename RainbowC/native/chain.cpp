@@ -0,0 +1,741 @@
+#include "chain.hpp"
+
+#include <eosio/crypto.hpp>
+#include <eosio/print.hpp>
+#include <eosio/system.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace native {
+
+const char* to_string( db_op op ) {
+   static const char* names[db_op_count] = { "find", "get", "next", "modify", "emplace", "erase" };
+   return names[size_t( op )];
+}
+
+uint32_t action_stats::count( db_op op ) const {
+   uint32_t n = 0;
+   for( const auto& t : db_ops ) n += t.second[size_t( op )];
+   return n;
+}
+
+uint32_t action_stats::count( name table, db_op op ) const {
+   auto t = db_ops.find( table );
+   return t == db_ops.end() ? 0 : t->second[size_t( op )];
+}
+
+int64_t action_stats::ram_bytes() const {
+   int64_t n = 0;
+   for( const auto& r : ram_delta ) n += r.second;
+   return n;
+}
+
+uint32_t action_stats::inline_count() const {
+   uint32_t n = 0;
+   for( const auto& a : inline_actions ) n += a.second;
+   return n;
+}
+
+std::string action_stats::report() const {
+   std::string out;
+   char line[128];
+   std::snprintf( line, sizeof(line), "%-13s", "table" );
+   out += line;
+   for( size_t op = 0; op < db_op_count; ++op ) {
+      std::snprintf( line, sizeof(line), " %7s", to_string( db_op( op ) ) );
+      out += line;
+   }
+   out += '\n';
+   for( const auto& t : db_ops ) {
+      std::snprintf( line, sizeof(line), "%-13s", t.first.to_string().c_str() );
+      out += line;
+      for( auto n : t.second ) {
+         std::snprintf( line, sizeof(line), " %7u", n );
+         out += line;
+      }
+      out += '\n';
+   }
+   for( const auto& r : ram_delta ) {
+      std::snprintf( line, sizeof(line), "ram %-13s %+lld bytes\n", r.first.to_string().c_str(), (long long)r.second );
+      out += line;
+   }
+   for( const auto& a : inline_actions ) {
+      std::snprintf( line, sizeof(line), "inline %s::%s x%u\n", a.first.first.to_string().c_str(),
+                     a.first.second.to_string().c_str(), a.second );
+      out += line;
+   }
+   return out;
+}
+
+namespace {
+   chain& default_chain() {
+      static chain c;
+      return c;
+   }
+   thread_local chain* current_chain = nullptr;
+}
+
+chain::chain()
+   : _now( eosio::time_point::from_iso_string( "2021-01-01T00:00:00" ) ) {}
+
+chain& chain::current() {
+   return current_chain ? *current_chain : default_chain();
+}
+
+void chain::make_current() {
+   current_chain = this;
+}
+
+void chain::create_account( name n ) {
+   _accounts.insert( n );
+}
+
+size_t chain::row_count( name code, uint64_t scope, name table ) const {
+   auto t = _tables.find( { code.value, scope, table.value } );
+   return t == _tables.end() ? 0 : t->second.rows.size();
+}
+
+size_t chain::index_row_count( name code, uint64_t scope, name table, uint32_t index ) const {
+   auto t = _indices.find( { code.value, scope, (table.value & 0xFFFFFFFFFFFFFFF0ULL) | index } );
+   return t == _indices.end() ? 0 : t->second.by_primary.size();
+}
+
+uint64_t chain::state_hash() const {
+   uint64_t sum = 0;
+   for( const auto& [key, t] : _tables ) {
+      for( const auto& [pk, r] : t.rows ) {
+         // FNV-1a
+         uint64_t h = 14695981039346656037ULL;
+         auto mix = [&]( const void* p, size_t n ) {
+            for( size_t i = 0; i < n; ++i ) {
+               h = ( h ^ static_cast<const unsigned char*>( p )[i] ) * 1099511628211ULL;
+            }
+         };
+         mix( &key.code, sizeof( key.code ) );
+         mix( &key.scope, sizeof( key.scope ) );
+         mix( &key.table, sizeof( key.table ) );
+         mix( &pk, sizeof( pk ) );
+         mix( &r.payer, sizeof( r.payer ) );
+         mix( r.data.data(), r.data.size() );
+         sum += h;
+      }
+   }
+   return sum;
+}
+
+int64_t chain::ram_usage( name payer ) const {
+   auto r = _ram.find( payer.value );
+   return r == _ram.end() ? 0 : r->second;
+}
+
+void chain::require_auth( name n ) const {
+   eosio::check( has_auth( n ), "missing authority of " + n.to_string() );
+}
+
+bool chain::has_auth( name n ) const {
+   for( const auto& a : _auths ) {
+      if( a == n ) return true;
+   }
+   return false;
+}
+
+void chain::require_recipient( name n ) {
+   for( const auto& a : _notified ) {
+      if( a == n ) return;
+   }
+   _notified.push_back( n );
+}
+
+void chain::send_inline( const eosio::action& act ) {
+#ifdef RAINBOW_INSTRUMENT
+   ++_stats.inline_actions[{ act.account, act.name }];
+#endif
+   _inline_actions.push_back( act );
+}
+
+void chain::print( const char* s, uint32_t len ) {
+   _console.append( s, len );
+}
+
+void chain::begin_action( name receiver, std::vector<name> auths ) {
+   _receiver = receiver;
+   _auths = std::move( auths );
+   _inline_actions.clear();
+   _notified.clear();
+   _console.clear();
+   _iterators.clear();
+   _iterator_lookup.clear();
+   _end_iterators.clear();
+   _idx_iterators.clear();
+   _idx_iterator_lookup.clear();
+   _idx_end_iterators.clear();
+   _undo.clear();
+   _journaled.clear();
+   _ram_at_begin = _ram;
+   _stats = action_stats();
+}
+
+void chain::end_action( action_result& result ) {
+   // RAM_RESTRICTIONS: an action may only add to the RAM of the receiver and its authorizers
+   for( const auto& r : result.ok ? _ram : decltype(_ram){} ) {
+      auto before = _ram_at_begin.find( r.first );
+      int64_t delta = r.second - ( before == _ram_at_begin.end() ? 0 : before->second );
+      if( delta > 0 && r.first != _receiver.value && !has_auth( name( r.first ) ) ) {
+         result.ok = false;
+         result.error = "unprivileged contract cannot increase RAM usage of another account that has not "
+                        "authorized the action: " + name( r.first ).to_string();
+         break;
+      }
+   }
+   if( !result.ok ) {
+      for( auto it = _undo.rbegin(); it != _undo.rend(); ++it ) {
+         if( it->table ) {
+            if( it->old_row ) it->table->rows[it->pk] = *it->old_row;
+            else              it->table->rows.erase( it->pk );
+            it->table->payer = it->old_table_payer;
+         } else {
+            auto& idx = *it->index;
+            auto cur = idx.by_primary.find( it->pk );
+            if( cur != idx.by_primary.end() ) {
+               idx.by_secondary.erase( { cur->second.key, it->pk } );
+               idx.by_primary.erase( cur );
+            }
+            if( it->old_entry ) {
+               idx.by_primary[it->pk] = *it->old_entry;
+               idx.by_secondary.insert( { it->old_entry->key, it->pk } );
+            }
+            idx.payer = it->old_table_payer;
+         }
+      }
+      _ram = _ram_at_begin;
+      _inline_actions.clear();
+      _notified.clear();
+      _stats.inline_actions.clear();
+   }
+#ifdef RAINBOW_INSTRUMENT
+   for( const auto& r : _ram ) {
+      auto before = _ram_at_begin.find( r.first );
+      int64_t delta = r.second - ( before == _ram_at_begin.end() ? 0 : before->second );
+      if( delta != 0 ) _stats.ram_delta[name( r.first )] = delta;
+   }
+#endif
+   result.stats = std::move( _stats );
+   _stats = action_stats();
+   result.inline_actions = std::move( _inline_actions );
+   result.notified = std::move( _notified );
+   result.console = std::move( _console );
+   _inline_actions.clear();
+   _notified.clear();
+   _console.clear();
+   _auths.clear();
+   _undo.clear();
+   _journaled.clear();
+}
+
+void chain::journal( primary_table* t, uint64_t pk ) {
+   if( !_journaled.insert( { t, pk } ).second ) return;
+   undo_entry e;
+   e.table = t;
+   e.pk = pk;
+   e.old_table_payer = t->payer;
+   auto r = t->rows.find( pk );
+   if( r != t->rows.end() ) e.old_row = r->second;
+   _undo.push_back( std::move( e ) );
+}
+
+void chain::journal( index_table* t, uint64_t pk ) {
+   if( !_journaled.insert( { t, pk } ).second ) return;
+   undo_entry e;
+   e.index = t;
+   e.pk = pk;
+   e.old_table_payer = t->payer;
+   auto r = t->by_primary.find( pk );
+   if( r != t->by_primary.end() ) e.old_entry = r->second;
+   _undo.push_back( std::move( e ) );
+}
+
+void chain::charge( uint64_t payer, int64_t delta ) {
+   _ram[payer] += delta;
+}
+
+chain::primary_table& chain::table_for( name code, uint64_t scope, uint64_t table ) {
+   table_key key{ code.value, scope, table };
+   auto& t = _tables[key];
+   t.key = key;
+   return t;
+}
+
+chain::primary_table* chain::find_table( uint64_t code, uint64_t scope, uint64_t table ) {
+   auto t = _tables.find( { code, scope, table } );
+   if( t == _tables.end() || t->second.rows.empty() ) return nullptr;
+   return &t->second;
+}
+
+chain::index_table* chain::find_index( uint64_t code, uint64_t scope, uint64_t table ) {
+   auto t = _indices.find( { code, scope, table } );
+   if( t == _indices.end() || t->second.by_primary.empty() ) return nullptr;
+   return &t->second;
+}
+
+int32_t chain::iterator_for( primary_table* t, uint64_t pk ) {
+   auto l = _iterator_lookup.find( { t, pk } );
+   if( l != _iterator_lookup.end() ) return l->second;
+   int32_t itr = int32_t( _iterators.size() );
+   _iterators.emplace_back( t, pk );
+   _iterator_lookup[{ t, pk }] = itr;
+   return itr;
+}
+
+int32_t chain::end_iterator_for( primary_table* t ) {
+   for( size_t i = 0; i < _end_iterators.size(); ++i ) {
+      if( _end_iterators[i] == t ) return -2 - int32_t(i);
+   }
+   _end_iterators.push_back( t );
+   return -1 - int32_t( _end_iterators.size() );
+}
+
+chain::primary_table* chain::table_of_end( int32_t iterator ) const {
+   size_t i = size_t( -2 - iterator );
+   eosio::check( i < _end_iterators.size(), "invalid end iterator" );
+   return _end_iterators[i];
+}
+
+int32_t chain::idx_iterator_for( index_table* t, uint64_t pk ) {
+   auto l = _idx_iterator_lookup.find( { t, pk } );
+   if( l != _idx_iterator_lookup.end() ) return l->second;
+   int32_t itr = int32_t( _idx_iterators.size() );
+   _idx_iterators.emplace_back( t, pk );
+   _idx_iterator_lookup[{ t, pk }] = itr;
+   return itr;
+}
+
+int32_t chain::idx_end_iterator_for( index_table* t ) {
+   for( size_t i = 0; i < _idx_end_iterators.size(); ++i ) {
+      if( _idx_end_iterators[i] == t ) return -2 - int32_t(i);
+   }
+   _idx_end_iterators.push_back( t );
+   return -1 - int32_t( _idx_end_iterators.size() );
+}
+
+chain::index_table* chain::index_of_end( int32_t iterator ) const {
+   size_t i = size_t( -2 - iterator );
+   eosio::check( i < _idx_end_iterators.size(), "invalid end iterator" );
+   return _idx_end_iterators[i];
+}
+
+int32_t chain::db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len ) {
+   count( table, db_op::emplace );
+   eosio::check( payer != 0, "must specify a valid account to pay for new record" );
+   auto& t = table_for( _receiver, scope, table );
+   eosio::check( t.rows.count( id ) == 0, "db_store_i64: primary key already exists" );
+   journal( &t, id );
+   if( t.rows.empty() ) {
+      t.payer = payer;
+      charge( payer, table_overhead_bytes );
+   }
+   auto& r = t.rows[id];
+   r.data.assign( (const char*)data, (const char*)data + len );
+   r.payer = payer;
+   charge( payer, int64_t( len ) + row_overhead_bytes );
+   return iterator_for( &t, id );
+}
+
+void chain::db_update_i64( int32_t iterator, uint64_t payer, const void* data, uint32_t len ) {
+   eosio::check( iterator >= 0 && size_t(iterator) < _iterators.size(), "invalid iterator" );
+   auto [t, pk] = _iterators[iterator];
+   count( t->key.table, db_op::modify );
+   eosio::check( t->key.code == _receiver.value, "db access violation" );
+   auto r = t->rows.find( pk );
+   eosio::check( r != t->rows.end(), "dereference of deleted object" );
+   journal( t, pk );
+   if( payer == 0 ) payer = r->second.payer;
+   int64_t old_size = int64_t( r->second.data.size() ) + row_overhead_bytes;
+   int64_t new_size = int64_t( len ) + row_overhead_bytes;
+   if( payer != r->second.payer ) {
+      charge( r->second.payer, -old_size );
+      charge( payer, new_size );
+   } else {
+      charge( payer, new_size - old_size );
+   }
+   r->second.data.assign( (const char*)data, (const char*)data + len );
+   r->second.payer = payer;
+}
+
+void chain::db_remove_i64( int32_t iterator ) {
+   eosio::check( iterator >= 0 && size_t(iterator) < _iterators.size(), "invalid iterator" );
+   auto [t, pk] = _iterators[iterator];
+   count( t->key.table, db_op::erase );
+   eosio::check( t->key.code == _receiver.value, "db access violation" );
+   auto r = t->rows.find( pk );
+   eosio::check( r != t->rows.end(), "dereference of deleted object" );
+   journal( t, pk );
+   charge( r->second.payer, -( int64_t( r->second.data.size() ) + row_overhead_bytes ) );
+   t->rows.erase( r );
+   if( t->rows.empty() ) {
+      charge( t->payer, -table_overhead_bytes );
+   }
+}
+
+int32_t chain::db_get_i64( int32_t iterator, void* data, uint32_t len ) {
+   eosio::check( iterator >= 0 && size_t(iterator) < _iterators.size(), "invalid iterator" );
+   auto [t, pk] = _iterators[iterator];
+   count( t->key.table, db_op::get );
+   auto r = t->rows.find( pk );
+   eosio::check( r != t->rows.end(), "dereference of deleted object" );
+   auto size = uint32_t( r->second.data.size() );
+   if( len == 0 ) return int32_t( size );
+   memcpy( data, r->second.data.data(), std::min( len, size ) );
+   return int32_t( std::min( len, size ) );
+}
+
+int32_t chain::db_next_i64( int32_t iterator, uint64_t* primary ) {
+   if( iterator < -1 ) return -1; // cannot increment past end iterator of table
+   eosio::check( iterator >= 0 && size_t(iterator) < _iterators.size(), "invalid iterator" );
+   auto [t, pk] = _iterators[iterator];
+   count( t->key.table, db_op::next );
+   auto next = t->rows.upper_bound( pk );
+   if( next == t->rows.end() ) return end_iterator_for( t );
+   *primary = next->first;
+   return iterator_for( t, next->first );
+}
+
+int32_t chain::db_previous_i64( int32_t iterator, uint64_t* primary ) {
+   primary_table* t = nullptr;
+   std::map<uint64_t, row>::iterator pos;
+   if( iterator < -1 ) {
+      t = table_of_end( iterator );
+      pos = t->rows.end();
+   } else {
+      eosio::check( iterator >= 0 && size_t(iterator) < _iterators.size(), "invalid iterator" );
+      t = _iterators[iterator].first;
+      pos = t->rows.lower_bound( _iterators[iterator].second );
+   }
+   count( t->key.table, db_op::next );
+   if( pos == t->rows.begin() ) return -1;
+   --pos;
+   *primary = pos->first;
+   return iterator_for( t, pos->first );
+}
+
+int32_t chain::db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   count( table, db_op::find );
+   auto t = find_table( code, scope, table );
+   if( !t ) return -1;
+   if( t->rows.count( id ) == 0 ) return end_iterator_for( t );
+   return iterator_for( t, id );
+}
+
+int32_t chain::db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   count( table, db_op::find );
+   auto t = find_table( code, scope, table );
+   if( !t ) return -1;
+   auto r = t->rows.lower_bound( id );
+   if( r == t->rows.end() ) return end_iterator_for( t );
+   return iterator_for( t, r->first );
+}
+
+int32_t chain::db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   count( table, db_op::find );
+   auto t = find_table( code, scope, table );
+   if( !t ) return -1;
+   auto r = t->rows.upper_bound( id );
+   if( r == t->rows.end() ) return end_iterator_for( t );
+   return iterator_for( t, r->first );
+}
+
+int32_t chain::db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
+   count( table, db_op::find );
+   auto t = find_table( code, scope, table );
+   if( !t ) return -1;
+   return end_iterator_for( t );
+}
+
+int32_t chain::db_idx_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const secondary_key& secondary, uint32_t key_size ) {
+   count( table, db_op::emplace );
+   eosio::check( payer != 0, "must specify a valid account to pay for new record" );
+   table_key key{ _receiver.value, scope, table };
+   auto& t = _indices[key];
+   t.key = key;
+   t.key_size = key_size;
+   eosio::check( t.by_primary.count( id ) == 0, "db_idx_store: primary key already exists" );
+   journal( &t, id );
+   if( t.by_primary.empty() ) {
+      t.payer = payer;
+      charge( payer, table_overhead_bytes );
+   }
+   t.by_primary[id] = { secondary, payer };
+   t.by_secondary.insert( { secondary, id } );
+   charge( payer, index_overhead_bytes + key_size );
+   return idx_iterator_for( &t, id );
+}
+
+void chain::db_idx_update( int32_t iterator, uint64_t payer, const secondary_key& secondary ) {
+   eosio::check( iterator >= 0 && size_t(iterator) < _idx_iterators.size(), "invalid iterator" );
+   auto [t, pk] = _idx_iterators[iterator];
+   count( t->key.table, db_op::modify );
+   eosio::check( t->key.code == _receiver.value, "db access violation" );
+   auto e = t->by_primary.find( pk );
+   eosio::check( e != t->by_primary.end(), "dereference of deleted object" );
+   journal( t, pk );
+   if( payer == 0 ) payer = e->second.payer;
+   if( payer != e->second.payer ) {
+      charge( e->second.payer, -( index_overhead_bytes + t->key_size ) );
+      charge( payer, index_overhead_bytes + t->key_size );
+   }
+   t->by_secondary.erase( { e->second.key, pk } );
+   e->second = { secondary, payer };
+   t->by_secondary.insert( { secondary, pk } );
+}
+
+void chain::db_idx_remove( int32_t iterator ) {
+   eosio::check( iterator >= 0 && size_t(iterator) < _idx_iterators.size(), "invalid iterator" );
+   auto [t, pk] = _idx_iterators[iterator];
+   count( t->key.table, db_op::erase );
+   eosio::check( t->key.code == _receiver.value, "db access violation" );
+   auto e = t->by_primary.find( pk );
+   eosio::check( e != t->by_primary.end(), "dereference of deleted object" );
+   journal( t, pk );
+   charge( e->second.payer, -( index_overhead_bytes + t->key_size ) );
+   t->by_secondary.erase( { e->second.key, pk } );
+   t->by_primary.erase( e );
+   if( t->by_primary.empty() ) {
+      charge( t->payer, -table_overhead_bytes );
+   }
+}
+
+int32_t chain::db_idx_next( int32_t iterator, uint64_t* primary ) {
+   if( iterator < -1 ) return -1;
+   eosio::check( iterator >= 0 && size_t(iterator) < _idx_iterators.size(), "invalid iterator" );
+   auto [t, pk] = _idx_iterators[iterator];
+   count( t->key.table, db_op::next );
+   auto e = t->by_primary.find( pk );
+   eosio::check( e != t->by_primary.end(), "dereference of deleted object" );
+   auto next = t->by_secondary.upper_bound( { e->second.key, pk } );
+   if( next == t->by_secondary.end() ) return idx_end_iterator_for( t );
+   *primary = next->second;
+   return idx_iterator_for( t, next->second );
+}
+
+int32_t chain::db_idx_previous( int32_t iterator, uint64_t* primary ) {
+   index_table* t = nullptr;
+   std::set<std::pair<secondary_key, uint64_t>>::iterator pos;
+   if( iterator < -1 ) {
+      t = index_of_end( iterator );
+      pos = t->by_secondary.end();
+   } else {
+      eosio::check( iterator >= 0 && size_t(iterator) < _idx_iterators.size(), "invalid iterator" );
+      t = _idx_iterators[iterator].first;
+      auto pk = _idx_iterators[iterator].second;
+      auto e = t->by_primary.find( pk );
+      eosio::check( e != t->by_primary.end(), "dereference of deleted object" );
+      pos = t->by_secondary.find( { e->second.key, pk } );
+   }
+   count( t->key.table, db_op::next );
+   if( pos == t->by_secondary.begin() ) return -1;
+   --pos;
+   *primary = pos->second;
+   return idx_iterator_for( t, pos->second );
+}
+
+int32_t chain::db_idx_find_primary( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t primary ) {
+   count( table, db_op::find );
+   auto t = find_index( code, scope, table );
+   if( !t ) return -1;
+   auto e = t->by_primary.find( primary );
+   if( e == t->by_primary.end() ) return idx_end_iterator_for( t );
+   *secondary = e->second.key;
+   return idx_iterator_for( t, primary );
+}
+
+int32_t chain::db_idx_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const secondary_key& secondary, uint64_t* primary ) {
+   count( table, db_op::find );
+   auto t = find_index( code, scope, table );
+   if( !t ) return -1;
+   auto e = t->by_secondary.lower_bound( { secondary, 0 } );
+   if( e == t->by_secondary.end() || e->first != secondary ) return idx_end_iterator_for( t );
+   *primary = e->second;
+   return idx_iterator_for( t, e->second );
+}
+
+int32_t chain::db_idx_lowerbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary ) {
+   count( table, db_op::find );
+   auto t = find_index( code, scope, table );
+   if( !t ) return -1;
+   auto e = t->by_secondary.lower_bound( { *secondary, 0 } );
+   if( e == t->by_secondary.end() ) return idx_end_iterator_for( t );
+   *secondary = e->first;
+   *primary = e->second;
+   return idx_iterator_for( t, e->second );
+}
+
+int32_t chain::db_idx_upperbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary ) {
+   count( table, db_op::find );
+   auto t = find_index( code, scope, table );
+   if( !t ) return -1;
+   auto e = t->by_secondary.upper_bound( { *secondary, std::numeric_limits<uint64_t>::max() } );
+   if( e == t->by_secondary.end() ) return idx_end_iterator_for( t );
+   *secondary = e->first;
+   *primary = e->second;
+   return idx_iterator_for( t, e->second );
+}
+
+int32_t chain::db_idx_end( uint64_t code, uint64_t scope, uint64_t table ) {
+   count( table, db_op::find );
+   auto t = find_index( code, scope, table );
+   if( !t ) return -1;
+   return idx_end_iterator_for( t );
+}
+
+} // namespace native
+
+// intrinsic entry points used by the host eosiolib headers
+
+extern "C" {
+
+void require_auth( capi_name n )                 { native::chain::current().require_auth( eosio::name( n ) ); }
+void require_auth2( capi_name n, capi_name )     { native::chain::current().require_auth( eosio::name( n ) ); }
+bool has_auth( capi_name n )                     { return native::chain::current().has_auth( eosio::name( n ) ); }
+bool is_account( capi_name n )                   { return native::chain::current().is_account( eosio::name( n ) ); }
+void require_recipient( capi_name n )            { native::chain::current().require_recipient( eosio::name( n ) ); }
+uint64_t current_time( void )                    { return uint64_t( native::chain::current().now().time_since_epoch().count() ); }
+capi_name current_receiver( void )               { return native::chain::current().receiver().value; }
+
+}
+
+namespace eosio { namespace internal_use_do_not_use {
+
+using native::chain;
+
+void prints_l( const char* s, uint32_t len ) { chain::current().print( s, len ); }
+
+void send_inline( const action& act ) { chain::current().send_inline( act ); }
+
+int32_t db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len ) {
+   return chain::current().db_store_i64( scope, table, payer, id, data, len );
+}
+void db_update_i64( int32_t iterator, uint64_t payer, const void* data, uint32_t len ) {
+   chain::current().db_update_i64( iterator, payer, data, len );
+}
+void db_remove_i64( int32_t iterator ) {
+   chain::current().db_remove_i64( iterator );
+}
+int32_t db_get_i64( int32_t iterator, const void* data, uint32_t len ) {
+   return chain::current().db_get_i64( iterator, const_cast<void*>( data ), len );
+}
+int32_t db_next_i64( int32_t iterator, uint64_t* primary ) {
+   return chain::current().db_next_i64( iterator, primary );
+}
+int32_t db_previous_i64( int32_t iterator, uint64_t* primary ) {
+   return chain::current().db_previous_i64( iterator, primary );
+}
+int32_t db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   return chain::current().db_find_i64( code, scope, table, id );
+}
+int32_t db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   return chain::current().db_lowerbound_i64( code, scope, table, id );
+}
+int32_t db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+   return chain::current().db_upperbound_i64( code, scope, table, id );
+}
+int32_t db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
+   return chain::current().db_end_i64( code, scope, table );
+}
+
+int32_t db_idx_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const secondary_key& secondary, uint32_t key_size ) {
+   return chain::current().db_idx_store( scope, table, payer, id, secondary, key_size );
+}
+void db_idx_update( int32_t iterator, uint64_t payer, const secondary_key& secondary ) {
+   chain::current().db_idx_update( iterator, payer, secondary );
+}
+void db_idx_remove( int32_t iterator ) {
+   chain::current().db_idx_remove( iterator );
+}
+int32_t db_idx_next( int32_t iterator, uint64_t* primary ) {
+   return chain::current().db_idx_next( iterator, primary );
+}
+int32_t db_idx_previous( int32_t iterator, uint64_t* primary ) {
+   return chain::current().db_idx_previous( iterator, primary );
+}
+int32_t db_idx_find_primary( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t primary ) {
+   return chain::current().db_idx_find_primary( code, scope, table, secondary, primary );
+}
+int32_t db_idx_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const secondary_key& secondary, uint64_t* primary ) {
+   return chain::current().db_idx_find_secondary( code, scope, table, secondary, primary );
+}
+int32_t db_idx_lowerbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary ) {
+   return chain::current().db_idx_lowerbound( code, scope, table, secondary, primary );
+}
+int32_t db_idx_upperbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary ) {
+   return chain::current().db_idx_upperbound( code, scope, table, secondary, primary );
+}
+int32_t db_idx_end( uint64_t code, uint64_t scope, uint64_t table ) {
+   return chain::current().db_idx_end( code, scope, table );
+}
+
+namespace {
+   // FIPS 180-4 SHA-256; the chain computes this natively
+   const uint32_t sha256_k[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+   };
+
+   uint32_t rotr( uint32_t x, int n ) { return (x >> n) | (x << (32 - n)); }
+
+   void sha256_block( uint32_t h[8], const uint8_t* p ) {
+      uint32_t w[64];
+      for( int i = 0; i < 16; ++i ) {
+         w[i] = uint32_t(p[4*i]) << 24 | uint32_t(p[4*i+1]) << 16 | uint32_t(p[4*i+2]) << 8 | p[4*i+3];
+      }
+      for( int i = 16; i < 64; ++i ) {
+         uint32_t s0 = rotr( w[i-15], 7 ) ^ rotr( w[i-15], 18 ) ^ (w[i-15] >> 3);
+         uint32_t s1 = rotr( w[i-2], 17 ) ^ rotr( w[i-2], 19 ) ^ (w[i-2] >> 10);
+         w[i] = w[i-16] + s0 + w[i-7] + s1;
+      }
+      uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+      for( int i = 0; i < 64; ++i ) {
+         uint32_t t1 = k + (rotr( e, 6 ) ^ rotr( e, 11 ) ^ rotr( e, 25 )) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+         uint32_t t2 = (rotr( a, 2 ) ^ rotr( a, 13 ) ^ rotr( a, 22 )) + ((a & b) ^ (a & c) ^ (b & c));
+         k = g; g = f; f = e; e = d + t1;
+         d = c; c = b; b = a; a = t1 + t2;
+      }
+      h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e; h[5] += f; h[6] += g; h[7] += k;
+   }
+}
+
+void sha256( const char* data, uint32_t length, checksum256* hash ) {
+   uint32_t h[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+   const uint8_t* p = reinterpret_cast<const uint8_t*>( data );
+   uint32_t n = length;
+   for( ; n >= 64; n -= 64, p += 64 ) {
+      sha256_block( h, p );
+   }
+   uint8_t tail[128] = {};
+   std::memcpy( tail, p, n );
+   tail[n] = 0x80;
+   size_t tail_len = n < 56 ? 64 : 128;
+   uint64_t bits = uint64_t( length ) * 8;
+   for( int i = 0; i < 8; ++i ) {
+      tail[tail_len - 1 - i] = uint8_t( bits >> (8 * i) );
+   }
+   for( size_t off = 0; off < tail_len; off += 64 ) {
+      sha256_block( h, tail + off );
+   }
+   uint8_t* out = hash->data();
+   for( int i = 0; i < 8; ++i ) {
+      out[4*i]   = uint8_t( h[i] >> 24 );
+      out[4*i+1] = uint8_t( h[i] >> 16 );
+      out[4*i+2] = uint8_t( h[i] >> 8 );
+      out[4*i+3] = uint8_t( h[i] );
+   }
+}
+
+} } // namespace eosio::internal_use_do_not_use
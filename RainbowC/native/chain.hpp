@@ -0,0 +1,257 @@
+/**
+ *  In-memory chain stand-in for native (host) builds of the rainbow contract.
+ *
+ *  The `chain` class implements the database, authorization, clock and inline-action
+ *  intrinsics that the host eosiolib headers call. Each `push` runs one action with
+ *  the given authorizations; a failed `check` rolls the action's writes back, like a
+ *  failed transaction on a real node. As under RAM_RESTRICTIONS, an action that adds to
+ *  the RAM of an account other than the receiver without its authorization fails. Inline
+ *  actions and notifications are recorded, not executed.
+ *
+ *  When built with RAINBOW_INSTRUMENT the chain also counts, per action, the database
+ *  operations on each table, the RAM charged to each payer and the inline actions sent.
+ */
+#pragma once
+
+#include <eosio/action.hpp>
+#include <eosio/datastream.hpp>
+#include <eosio/multi_index.hpp>
+#include <eosio/name.hpp>
+#include <eosio/time.hpp>
+
+#include <array>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace native {
+
+   using eosio::name;
+   using eosio::internal_use_do_not_use::secondary_key;
+
+   /// nodeos billable sizes (config::billable_size_v), used for RAM accounting
+   constexpr int64_t table_overhead_bytes = 108;
+   constexpr int64_t row_overhead_bytes   = 108;
+   constexpr int64_t index_overhead_bytes = 24 + 3*32;
+
+   /// database operations counted by the instrumentation; index operations count against their table
+   enum class db_op { find, get, next, modify, emplace, erase };
+   constexpr size_t db_op_count = 6;
+
+   const char* to_string( db_op op );
+
+   /// resources used by one action; empty unless built with RAINBOW_INSTRUMENT
+   struct action_stats {
+      std::map<name, std::array<uint32_t, db_op_count>> db_ops;          ///< counts by table
+      std::map<name, int64_t>                           ram_delta;       ///< bytes by payer
+      std::map<std::pair<name, name>, uint32_t>         inline_actions;  ///< counts by (account, action)
+
+      uint32_t count( db_op op ) const;
+      uint32_t count( name table, db_op op ) const;
+      int64_t  ram_bytes() const;
+      uint32_t inline_count() const;
+
+      /// human-readable table of the above, one line per table, payer and inline action
+      std::string report() const;
+   };
+
+   struct action_result {
+      bool                       ok = false;
+      std::string                error;
+      std::vector<eosio::action> inline_actions;
+      std::vector<name>          notified;
+      std::string                console;
+      action_stats               stats;
+   };
+
+   class chain {
+   public:
+      chain();
+      chain( const chain& ) = delete;
+      chain& operator=( const chain& ) = delete;
+
+      /// the chain that intrinsics called on this thread operate on
+      static chain& current();
+      void make_current();
+
+      void create_account( name n );
+      bool is_account( name n ) const { return _accounts.count( n ) != 0; }
+
+      eosio::time_point now() const { return _now; }
+      void set_time( eosio::time_point t ) { _now = t; }
+      void advance( eosio::microseconds d ) { _now += d; }
+
+      /**
+       * Runs `fn` as an action received by `receiver` and authorized by `auths`.
+       * On a failed check every row written by the action is restored.
+       */
+      template<typename F>
+      action_result push( name receiver, std::vector<name> auths, F&& fn ) {
+         begin_action( receiver, std::move( auths ) );
+         action_result result;
+         try {
+            fn();
+            result.ok = true;
+         } catch( const eosio::check_error& e ) {
+            result.error = e.what();
+         }
+         end_action( result );
+         return result;
+      }
+
+      /// writes a row directly, e.g. to seed balances held by another token contract
+      template<typename T>
+      void put_row( name code, uint64_t scope, name table, uint64_t pk, const T& value, name payer ) {
+         auto& t = table_for( code, scope, table.value );
+         auto& r = t.rows[pk];
+         r.data = eosio::pack( value );
+         r.payer = payer.value;
+      }
+
+      template<typename T>
+      std::optional<T> get_row( name code, uint64_t scope, name table, uint64_t pk ) const {
+         auto t = _tables.find( { code.value, scope, table.value } );
+         if( t == _tables.end() ) return {};
+         auto r = t->second.rows.find( pk );
+         if( r == t->second.rows.end() ) return {};
+         return eosio::unpack<T>( r->second.data );
+      }
+
+      size_t row_count( name code, uint64_t scope, name table ) const;
+      /// rows of secondary index `index` of a table, 0 for its first index
+      size_t index_row_count( name code, uint64_t scope, name table, uint32_t index = 0 ) const;
+
+      /**
+       * Hash of every table row (code, scope, table, primary key, payer and data). Row
+       * hashes are summed, so chains holding disjoint rows add up to the hash of one chain
+       * holding all of them.
+       */
+      uint64_t state_hash() const;
+      int64_t ram_usage( name payer ) const;
+
+      // intrinsic implementations
+      void require_auth( name n ) const;
+      bool has_auth( name n ) const;
+      void require_recipient( name n );
+      void send_inline( const eosio::action& act );
+      void print( const char* s, uint32_t len );
+      name receiver() const { return _receiver; }
+
+      int32_t db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len );
+      void    db_update_i64( int32_t iterator, uint64_t payer, const void* data, uint32_t len );
+      void    db_remove_i64( int32_t iterator );
+      int32_t db_get_i64( int32_t iterator, void* data, uint32_t len );
+      int32_t db_next_i64( int32_t iterator, uint64_t* primary );
+      int32_t db_previous_i64( int32_t iterator, uint64_t* primary );
+      int32_t db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_end_i64( uint64_t code, uint64_t scope, uint64_t table );
+
+      int32_t db_idx_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const secondary_key& secondary, uint32_t key_size );
+      void    db_idx_update( int32_t iterator, uint64_t payer, const secondary_key& secondary );
+      void    db_idx_remove( int32_t iterator );
+      int32_t db_idx_next( int32_t iterator, uint64_t* primary );
+      int32_t db_idx_previous( int32_t iterator, uint64_t* primary );
+      int32_t db_idx_find_primary( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t primary );
+      int32_t db_idx_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const secondary_key& secondary, uint64_t* primary );
+      int32_t db_idx_lowerbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary );
+      int32_t db_idx_upperbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary );
+      int32_t db_idx_end( uint64_t code, uint64_t scope, uint64_t table );
+
+   private:
+      struct table_key {
+         uint64_t code;
+         uint64_t scope;
+         uint64_t table;
+         friend bool operator < ( const table_key& a, const table_key& b ) {
+            return std::tie( a.code, a.scope, a.table ) < std::tie( b.code, b.scope, b.table );
+         }
+      };
+
+      struct row {
+         std::vector<char> data;
+         uint64_t          payer = 0;
+      };
+
+      struct primary_table {
+         table_key                key;
+         std::map<uint64_t, row>  rows;
+         uint64_t                 payer = 0;
+      };
+
+      struct index_entry {
+         secondary_key key;
+         uint64_t      payer = 0;
+      };
+
+      struct index_table {
+         table_key                                      key;
+         uint32_t                                       key_size = 0;
+         std::map<uint64_t, index_entry>                by_primary;
+         std::set<std::pair<secondary_key, uint64_t>>   by_secondary;
+         uint64_t                                       payer = 0;
+      };
+
+      struct undo_entry {
+         primary_table*             table = nullptr;
+         index_table*               index = nullptr;
+         uint64_t                   pk = 0;
+         std::optional<row>         old_row;
+         std::optional<index_entry> old_entry;
+         uint64_t                   old_table_payer = 0;
+      };
+
+      primary_table& table_for( name code, uint64_t scope, uint64_t table );
+      primary_table* find_table( uint64_t code, uint64_t scope, uint64_t table );
+      index_table* find_index( uint64_t code, uint64_t scope, uint64_t table );
+
+      int32_t iterator_for( primary_table* t, uint64_t pk );
+      int32_t end_iterator_for( primary_table* t );
+      primary_table* table_of_end( int32_t iterator ) const;
+      int32_t idx_iterator_for( index_table* t, uint64_t pk );
+      int32_t idx_end_iterator_for( index_table* t );
+      index_table* index_of_end( int32_t iterator ) const;
+
+      void count( uint64_t table, db_op op ) {
+#ifdef RAINBOW_INSTRUMENT
+         // secondary index tables carry the index number in the low four bits
+         ++_stats.db_ops[name( table & 0xFFFFFFFFFFFFFFF0ULL )][size_t( op )];
+#endif
+      }
+
+      void journal( primary_table* t, uint64_t pk );
+      void journal( index_table* t, uint64_t pk );
+      void charge( uint64_t payer, int64_t delta );
+
+      void begin_action( name receiver, std::vector<name> auths );
+      void end_action( action_result& result );
+
+      std::set<name>                       _accounts;
+      eosio::time_point                    _now;
+      std::map<table_key, primary_table>   _tables;
+      std::map<table_key, index_table>     _indices;
+      std::map<uint64_t, int64_t>          _ram;
+
+      // per-action state
+      name                                 _receiver;
+      std::vector<name>                    _auths;
+      std::vector<eosio::action>           _inline_actions;
+      std::vector<name>                    _notified;
+      std::string                          _console;
+      std::vector<std::pair<primary_table*, uint64_t>> _iterators;
+      std::map<std::pair<primary_table*, uint64_t>, int32_t> _iterator_lookup;
+      std::vector<primary_table*>          _end_iterators;
+      std::vector<std::pair<index_table*, uint64_t>> _idx_iterators;
+      std::map<std::pair<index_table*, uint64_t>, int32_t> _idx_iterator_lookup;
+      std::vector<index_table*>            _idx_end_iterators;
+      std::vector<undo_entry>              _undo;
+      std::set<std::pair<const void*, uint64_t>> _journaled;
+      std::map<uint64_t, int64_t>          _ram_at_begin;
+      action_stats                         _stats;
+   };
+
+} // namespace native
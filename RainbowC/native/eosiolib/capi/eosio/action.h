@@ -0,0 +1,23 @@
+/**
+ *  Host stand-in for the eosio.cdt action C API. The functions are implemented
+ *  by the in-memory chain (native/chain.cpp).
+ */
+#pragma once
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void require_auth( capi_name name );
+void require_auth2( capi_name name, capi_name permission );
+bool has_auth( capi_name name );
+bool is_account( capi_name name );
+void require_recipient( capi_name name );
+uint64_t current_time( void );
+capi_name current_receiver( void );
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+/**
+ *  Host stand-in for the eosio.cdt C API type definitions.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
+
+typedef uint64_t capi_name;
@@ -0,0 +1,103 @@
+/**
+ *  Host stand-in for <eosio/action.hpp>. Inline actions are handed to the in-memory
+ *  chain, which records them for the running action instead of executing them.
+ */
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../../capi/eosio/action.h"
+#include "datastream.hpp"
+#include "name.hpp"
+
+namespace eosio {
+
+   struct permission_level {
+      permission_level( name a, name p ) : actor(a), permission(p) {}
+      permission_level() {}
+
+      name actor;
+      name permission;
+
+      friend bool operator == ( const permission_level& a, const permission_level& b ) {
+         return a.actor == b.actor && a.permission == b.permission;
+      }
+   };
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const permission_level& v ) { return ds << v.actor << v.permission; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, permission_level& v )       { return ds >> v.actor >> v.permission; }
+
+   struct action;
+
+   namespace internal_use_do_not_use {
+      void send_inline( const action& act );
+   }
+
+   inline void require_auth( name n )      { ::require_auth( n.value ); }
+   inline void require_auth( const permission_level& level ) { ::require_auth2( level.actor.value, level.permission.value ); }
+   inline bool has_auth( name n )          { return ::has_auth( n.value ); }
+   inline bool is_account( name n )        { return ::is_account( n.value ); }
+   inline void require_recipient( name n ) { ::require_recipient( n.value ); }
+
+   template<typename... accounts>
+   void require_recipient( name n, accounts... remaining_accounts ) {
+      require_recipient( n );
+      require_recipient( remaining_accounts... );
+   }
+
+   struct action {
+      eosio::name                   account;
+      eosio::name                   name;
+      std::vector<permission_level> authorization;
+      std::vector<char>             data;
+
+      action() = default;
+
+      template<typename T>
+      action( const permission_level& auth, struct name a, struct name n, T&& value )
+         : account(a), name(n), authorization(1, auth), data( pack( std::forward<T>( value ) ) ) {}
+
+      template<typename T>
+      action( std::vector<permission_level> auths, struct name a, struct name n, T&& value )
+         : account(a), name(n), authorization( std::move( auths ) ), data( pack( std::forward<T>( value ) ) ) {}
+
+      void send() const {
+         internal_use_do_not_use::send_inline( *this );
+      }
+
+      template<typename T>
+      T data_as() const {
+         return unpack<T>( data );
+      }
+   };
+
+   template<eosio::name::raw Name, auto Action>
+   struct action_wrapper {
+      template<typename Code>
+      constexpr action_wrapper( Code&& code, std::vector<permission_level>&& perms )
+         : code_name( std::forward<Code>( code ) ), permissions( std::move( perms ) ) {}
+
+      template<typename Code>
+      constexpr action_wrapper( Code&& code, const permission_level& perm )
+         : code_name( std::forward<Code>( code ) ), permissions( { perm } ) {}
+
+      static constexpr eosio::name action_name = eosio::name( Name );
+      eosio::name code_name;
+      std::vector<permission_level> permissions;
+
+      template<typename... Args>
+      action to_action( Args&&... args ) const {
+         return action( permissions, code_name, action_name, std::make_tuple( std::forward<Args>( args )... ) );
+      }
+
+      template<typename... Args>
+      void send( Args&&... args ) const {
+         to_action( std::forward<Args>( args )... ).send();
+      }
+   };
+
+} // namespace eosio
@@ -0,0 +1,39 @@
+/**
+ *  Host stand-in for <eosio/check.hpp>. A failed check throws `check_error`, which the
+ *  in-memory chain catches to roll back the action that raised it.
+ */
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "../../capi/eosio/types.h"
+
+namespace eosio {
+
+   struct check_error : std::runtime_error {
+      using std::runtime_error::runtime_error;
+   };
+
+   [[noreturn]] inline void assert_failed( std::string_view msg ) {
+      throw check_error( std::string( msg ) );
+   }
+
+   inline void check( bool pred, const char* msg ) {
+      if( !pred ) assert_failed( msg );
+   }
+
+   inline void check( bool pred, const std::string& msg ) {
+      if( !pred ) assert_failed( msg );
+   }
+
+   inline void check( bool pred, std::string_view msg ) {
+      if( !pred ) assert_failed( msg );
+   }
+
+   inline void check( bool pred, uint64_t code ) {
+      if( !pred ) assert_failed( "assertion failure with error code: " + std::to_string( code ) );
+   }
+
+} // namespace eosio
@@ -0,0 +1,25 @@
+/**
+ *  Host stand-in for <eosio/crypto.hpp>. The hash is computed by the host
+ *  (native/chain.cpp) in place of the chain intrinsic.
+ */
+#pragma once
+
+#include "fixed_bytes.hpp"
+
+namespace eosio {
+
+   namespace internal_use_do_not_use {
+      void sha256( const char* data, uint32_t length, checksum256* hash );
+   }
+
+   inline checksum256 sha256( const char* data, uint32_t length ) {
+      checksum256 hash;
+      internal_use_do_not_use::sha256( data, length, &hash );
+      return hash;
+   }
+
+   inline void assert_sha256( const char* data, uint32_t length, const checksum256& hash ) {
+      check( sha256( data, length ) == hash, "hash mismatch" );
+   }
+
+} // namespace eosio
@@ -0,0 +1,383 @@
+/**
+ *  Host stand-in for <eosio/datastream.hpp> and <eosio/serialize.hpp>.
+ *
+ *  Plain aggregate structs (table rows, action parameter structs) are serialized
+ *  field by field in declaration order, as eosio.cdt does, using a small
+ *  structured-binding reflection in place of boost::pfr.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "name.hpp"
+#include "symbol.hpp"
+#include "asset.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+   template<typename T>
+   class datastream {
+   public:
+      datastream( T start, size_t s ) : _start(start), _pos(start), _end(start + s) {}
+
+      inline void skip( size_t s ) { _pos += s; }
+
+      inline bool read( char* d, size_t s ) {
+         check( size_t(_end - _pos) >= s, "datastream attempted to read past the end" );
+         memcpy( d, _pos, s );
+         _pos += s;
+         return true;
+      }
+
+      inline bool write( const char* d, size_t s ) {
+         check( size_t(_end - _pos) >= s, "datastream attempted to write past the end" );
+         memcpy( (void*)_pos, d, s );
+         _pos += s;
+         return true;
+      }
+
+      inline bool write( char d ) { return write( &d, 1 ); }
+
+      T pos() const { return _pos; }
+      inline bool valid() const { return _pos <= _end && _pos >= _start; }
+      inline bool seekp( size_t p ) { _pos = _start + p; return _pos <= _end; }
+      inline size_t tellp() const { return size_t(_pos - _start); }
+      inline size_t remaining() const { return size_t(_end - _pos); }
+
+   private:
+      T _start;
+      T _pos;
+      T _end;
+   };
+
+   template<>
+   class datastream<size_t> {
+   public:
+      datastream( size_t init_size = 0 ) : _size(init_size) {}
+      inline bool skip( size_t s ) { _size += s; return true; }
+      inline bool write( const char*, size_t s ) { _size += s; return true; }
+      inline bool write( char ) { _size++; return true; }
+      inline bool valid() const { return true; }
+      inline bool seekp( size_t p ) { _size = p; return true; }
+      inline size_t tellp() const { return _size; }
+      inline size_t remaining() const { return 0; }
+   private:
+      size_t _size;
+   };
+
+   namespace _datastream_detail {
+
+      template<typename T>
+      constexpr bool is_pointer() {
+         return std::is_pointer<T>::value ||
+                std::is_null_pointer<T>::value ||
+                std::is_member_pointer<T>::value;
+      }
+
+      template<typename T>
+      constexpr bool is_primitive() {
+         return std::is_arithmetic<T>::value ||
+                std::is_same<T, int128_t>::value ||
+                std::is_same<T, uint128_t>::value;
+      }
+
+      /// aggregate field count detection, as used by boost::pfr
+      struct any_field {
+         template<typename T>
+         constexpr operator T() const;
+      };
+
+      template<typename T, typename... A>
+      constexpr auto is_brace_constructible( int ) -> decltype( T{ std::declval<A>()... }, std::true_type{} );
+
+      template<typename T, typename...>
+      constexpr std::false_type is_brace_constructible( ... );
+
+      template<size_t>
+      using any_field_n = any_field;
+
+      template<typename T, size_t... I>
+      constexpr bool brace_constructible_with( std::index_sequence<I...> ) {
+         return decltype( is_brace_constructible<T, any_field_n<I>...>(0) )::value;
+      }
+
+      /// searches downward: members left to {} may be unconstructible (explicit default ctors)
+      template<typename T, size_t N = 12>
+      constexpr size_t field_count() {
+         if constexpr( N == 0 || brace_constructible_with<T>( std::make_index_sequence<N>{} ) ) {
+            return N;
+         } else {
+            return field_count<T, N - 1>();
+         }
+      }
+
+      template<typename T, typename F>
+      void for_each_field( T&& v, F&& f ) {
+         constexpr size_t n = field_count<std::decay_t<T>>();
+         if constexpr( n == 0 ) {
+         } else if constexpr( n == 1 ) {
+            auto& [a] = v; f(a);
+         } else if constexpr( n == 2 ) {
+            auto& [a,b] = v; f(a); f(b);
+         } else if constexpr( n == 3 ) {
+            auto& [a,b,c] = v; f(a); f(b); f(c);
+         } else if constexpr( n == 4 ) {
+            auto& [a,b,c,d] = v; f(a); f(b); f(c); f(d);
+         } else if constexpr( n == 5 ) {
+            auto& [a,b,c,d,e] = v; f(a); f(b); f(c); f(d); f(e);
+         } else if constexpr( n == 6 ) {
+            auto& [a,b,c,d,e,g] = v; f(a); f(b); f(c); f(d); f(e); f(g);
+         } else if constexpr( n == 7 ) {
+            auto& [a,b,c,d,e,g,h] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h);
+         } else if constexpr( n == 8 ) {
+            auto& [a,b,c,d,e,g,h,i] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i);
+         } else if constexpr( n == 9 ) {
+            auto& [a,b,c,d,e,g,h,i,j] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j);
+         } else if constexpr( n == 10 ) {
+            auto& [a,b,c,d,e,g,h,i,j,k] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k);
+         } else if constexpr( n == 11 ) {
+            auto& [a,b,c,d,e,g,h,i,j,k,l] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l);
+         } else if constexpr( n == 12 ) {
+            auto& [a,b,c,d,e,g,h,i,j,k,l,m] = v; f(a); f(b); f(c); f(d); f(e); f(g); f(h); f(i); f(j); f(k); f(l); f(m);
+         } else {
+            static_assert( n <= 12, "host datastream supports aggregates of at most 12 fields" );
+         }
+      }
+
+      template<typename T>
+      constexpr bool is_reflected_aggregate() {
+         return std::is_class<T>::value && std::is_aggregate<T>::value;
+      }
+   }
+
+   struct unsigned_int {
+      unsigned_int( uint32_t v = 0 ) : value(v) {}
+      operator uint32_t() const { return value; }
+      uint32_t value;
+   };
+
+   template<typename Stream>
+   inline datastream<Stream>& operator<<( datastream<Stream>& ds, const unsigned_int& v ) {
+      uint64_t val = v.value;
+      do {
+         uint8_t b = uint8_t(val) & 0x7f;
+         val >>= 7;
+         b |= ((val > 0) << 7);
+         ds.write( (char)b );
+      } while( val );
+      return ds;
+   }
+
+   template<typename Stream>
+   inline datastream<Stream>& operator>>( datastream<Stream>& ds, unsigned_int& vi ) {
+      uint64_t v = 0; char b = 0; uint8_t by = 0;
+      do {
+         ds.read( &b, 1 );
+         v |= uint32_t(uint8_t(b) & 0x7f) << by;
+         by += 7;
+      } while( uint8_t(b) & 0x80 );
+      vi.value = static_cast<uint32_t>(v);
+      return ds;
+   }
+
+   template<typename Stream, typename T, std::enable_if_t<_datastream_detail::is_primitive<T>()>* = nullptr>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+      ds.write( (const char*)&v, sizeof(T) );
+      return ds;
+   }
+
+   template<typename Stream, typename T, std::enable_if_t<_datastream_detail::is_primitive<T>()>* = nullptr>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, T& v ) {
+      ds.read( (char*)&v, sizeof(T) );
+      return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const name& v )        { return ds << v.value; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, name& v )              { return ds >> v.value; }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol_code& v ) { return ds << v.raw(); }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, symbol_code& v ) {
+      uint64_t raw; ds >> raw; v = symbol_code( raw ); return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const symbol& v )      { return ds << v.raw(); }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, symbol& v ) {
+      uint64_t raw; ds >> raw; v = symbol( raw ); return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const asset& v )       { return ds << v.amount << v.symbol; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, asset& v )             { return ds >> v.amount >> v.symbol; }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const microseconds& v ) { return ds << v._count; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, microseconds& v )       { return ds >> v._count; }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const time_point& v )  { return ds << v.elapsed; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, time_point& v )        { return ds >> v.elapsed; }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const time_point_sec& v ) { return ds << v.utc_seconds; }
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, time_point_sec& v )       { return ds >> v.utc_seconds; }
+
+   template<typename Stream>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::string& v ) {
+      ds << unsigned_int( v.size() );
+      if( v.size() ) ds.write( v.data(), v.size() );
+      return ds;
+   }
+
+   template<typename Stream>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::string& v ) {
+      unsigned_int s;
+      ds >> s;
+      v.resize( s.value );
+      if( s.value ) ds.read( v.data(), s.value );
+      return ds;
+   }
+
+   template<typename Stream, typename T, size_t N>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::array<T,N>& v ) {
+      for( const auto& i : v ) ds << i;
+      return ds;
+   }
+
+   template<typename Stream, typename T, size_t N>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::array<T,N>& v ) {
+      for( auto& i : v ) ds >> i;
+      return ds;
+   }
+
+   template<typename Stream, typename T>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::vector<T>& v ) {
+      ds << unsigned_int( v.size() );
+      for( const auto& i : v ) ds << i;
+      return ds;
+   }
+
+   template<typename Stream, typename T>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::vector<T>& v ) {
+      unsigned_int s;
+      ds >> s;
+      v.resize( s.value );
+      for( auto& i : v ) ds >> i;
+      return ds;
+   }
+
+   template<typename Stream, typename T>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::optional<T>& v ) {
+      char valid = v.has_value();
+      ds << valid;
+      if( valid ) ds << *v;
+      return ds;
+   }
+
+   template<typename Stream, typename T>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::optional<T>& v ) {
+      char valid = 0;
+      ds >> valid;
+      if( valid ) {
+         T val;
+         ds >> val;
+         v = std::move( val );
+      } else {
+         v.reset();
+      }
+      return ds;
+   }
+
+   template<typename Stream, typename K, typename V>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::pair<K,V>& v ) {
+      return ds << v.first << v.second;
+   }
+
+   template<typename Stream, typename K, typename V>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::pair<K,V>& v ) {
+      return ds >> v.first >> v.second;
+   }
+
+   template<typename Stream, typename K, typename V>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::map<K,V>& m ) {
+      ds << unsigned_int( m.size() );
+      for( const auto& i : m ) ds << i.first << i.second;
+      return ds;
+   }
+
+   template<typename Stream, typename... Args>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const std::tuple<Args...>& t ) {
+      std::apply( [&]( const auto&... e ) { ( ds << ... << e ); }, t );
+      return ds;
+   }
+
+   template<typename Stream, typename... Args>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, std::tuple<Args...>& t ) {
+      std::apply( [&]( auto&... e ) { ( ds >> ... >> e ); }, t );
+      return ds;
+   }
+
+   template<typename Stream, typename T,
+            std::enable_if_t<_datastream_detail::is_reflected_aggregate<T>()>* = nullptr>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const T& v ) {
+      _datastream_detail::for_each_field( v, [&]( const auto& field ) { ds << field; } );
+      return ds;
+   }
+
+   template<typename Stream, typename T,
+            std::enable_if_t<_datastream_detail::is_reflected_aggregate<T>()>* = nullptr>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, T& v ) {
+      _datastream_detail::for_each_field( v, [&]( auto& field ) { ds >> field; } );
+      return ds;
+   }
+
+   template<typename T>
+   size_t pack_size( const T& value ) {
+      datastream<size_t> ps;
+      ps << value;
+      return ps.tellp();
+   }
+
+   template<typename T>
+   std::vector<char> pack( const T& value ) {
+      std::vector<char> result;
+      result.resize( pack_size( value ) );
+      datastream<char*> ds( result.data(), result.size() );
+      ds << value;
+      return result;
+   }
+
+   template<typename T>
+   T unpack( const char* buffer, size_t len ) {
+      T result;
+      datastream<const char*> ds( buffer, len );
+      ds >> result;
+      return result;
+   }
+
+   template<typename T>
+   T unpack( const std::vector<char>& bytes ) {
+      return unpack<T>( bytes.data(), bytes.size() );
+   }
+
+} // namespace eosio
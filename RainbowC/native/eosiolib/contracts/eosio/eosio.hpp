@@ -0,0 +1,15 @@
+/**
+ *  Host stand-in for <eosio/eosio.hpp>.
+ */
+#pragma once
+
+#include <cctype>
+
+#include "action.hpp"
+#include "check.hpp"
+#include "contract.hpp"
+#include "datastream.hpp"
+#include "multi_index.hpp"
+#include "name.hpp"
+#include "print.hpp"
+#include "system.hpp"
@@ -0,0 +1,74 @@
+/**
+ *  Host stand-in for <eosio/fixed_bytes.hpp>.
+ *
+ *  Bytes are kept in order; `get_array` packs them big-endian into 128-bit words
+ *  as eosio.cdt does, so word order and byte order compare the same way.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "datastream.hpp"
+
+namespace eosio {
+
+   template<size_t Size>
+   class fixed_bytes {
+   public:
+      static_assert( Size % 16 == 0, "host fixed_bytes supports multiples of 16 bytes only" );
+      static constexpr size_t num_words() { return Size / 16; }
+
+      fixed_bytes() : _bytes{} {}
+      fixed_bytes( const std::array<uint8_t, Size>& bytes ) : _bytes( bytes ) {}
+      fixed_bytes( const std::array<uint128_t, num_words()>& words ) {
+         for( size_t w = 0; w < num_words(); ++w ) {
+            for( size_t b = 0; b < 16; ++b ) {
+               _bytes[w*16 + b] = uint8_t( words[w] >> (8 * (15 - b)) );
+            }
+         }
+      }
+
+      std::array<uint128_t, num_words()> get_array() const {
+         std::array<uint128_t, num_words()> words{};
+         for( size_t w = 0; w < num_words(); ++w ) {
+            for( size_t b = 0; b < 16; ++b ) {
+               words[w] = (words[w] << 8) | _bytes[w*16 + b];
+            }
+         }
+         return words;
+      }
+
+      std::array<uint8_t, Size> extract_as_byte_array() const { return _bytes; }
+
+      const uint8_t* data() const { return _bytes.data(); }
+      uint8_t* data() { return _bytes.data(); }
+      static constexpr size_t size() { return Size; }
+
+      friend bool operator == ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes == b._bytes; }
+      friend bool operator != ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes != b._bytes; }
+      friend bool operator <  ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes <  b._bytes; }
+      friend bool operator >  ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes >  b._bytes; }
+      friend bool operator <= ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes <= b._bytes; }
+      friend bool operator >= ( const fixed_bytes& a, const fixed_bytes& b ) { return a._bytes >= b._bytes; }
+
+   private:
+      std::array<uint8_t, Size> _bytes;
+   };
+
+   using checksum256 = fixed_bytes<32>;
+
+   template<typename Stream, size_t Size>
+   datastream<Stream>& operator<<( datastream<Stream>& ds, const fixed_bytes<Size>& v ) {
+      ds.write( (const char*)v.data(), Size );
+      return ds;
+   }
+
+   template<typename Stream, size_t Size>
+   datastream<Stream>& operator>>( datastream<Stream>& ds, fixed_bytes<Size>& v ) {
+      ds.read( (char*)v.data(), Size );
+      return ds;
+   }
+
+} // namespace eosio
@@ -0,0 +1,648 @@
+/**
+ *  Host stand-in for <eosio/multi_index.hpp>.
+ *
+ *  Mirrors the eosio.cdt implementation: rows are serialized into the in-memory
+ *  chain through db_*_i64 / db_idx_* calls, and objects loaded during an action are
+ *  cached by the table instance so repeated finds on one instance do not touch the db.
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "check.hpp"
+#include "datastream.hpp"
+#include "fixed_bytes.hpp"
+#include "name.hpp"
+#include "system.hpp"
+
+namespace eosio {
+
+   namespace internal_use_do_not_use {
+      int32_t db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const void* data, uint32_t len );
+      void    db_update_i64( int32_t iterator, uint64_t payer, const void* data, uint32_t len );
+      void    db_remove_i64( int32_t iterator );
+      int32_t db_get_i64( int32_t iterator, const void* data, uint32_t len );
+      int32_t db_next_i64( int32_t iterator, uint64_t* primary );
+      int32_t db_previous_i64( int32_t iterator, uint64_t* primary );
+      int32_t db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id );
+      int32_t db_end_i64( uint64_t code, uint64_t scope, uint64_t table );
+
+      /// secondary keys of every width are held as two big-endian-ordered 128-bit words
+      using secondary_key = std::array<uint128_t, 2>;
+
+      int32_t db_idx_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id,
+                            const secondary_key& secondary, uint32_t key_size );
+      void    db_idx_update( int32_t iterator, uint64_t payer, const secondary_key& secondary );
+      void    db_idx_remove( int32_t iterator );
+      int32_t db_idx_next( int32_t iterator, uint64_t* primary );
+      int32_t db_idx_previous( int32_t iterator, uint64_t* primary );
+      int32_t db_idx_find_primary( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t primary );
+      int32_t db_idx_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const secondary_key& secondary, uint64_t* primary );
+      int32_t db_idx_lowerbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary );
+      int32_t db_idx_upperbound( uint64_t code, uint64_t scope, uint64_t table, secondary_key* secondary, uint64_t* primary );
+      int32_t db_idx_end( uint64_t code, uint64_t scope, uint64_t table );
+   }
+
+   constexpr static inline name same_payer{};
+
+   template<typename T, typename Enable = void>
+   struct secondary_key_traits;
+
+   template<>
+   struct secondary_key_traits<uint64_t> {
+      static constexpr uint32_t size = sizeof(uint64_t);
+      static uint64_t lowest() { return 0; }
+      static internal_use_do_not_use::secondary_key to_key( uint64_t v ) { return { 0, v }; }
+      static uint64_t from_key( const internal_use_do_not_use::secondary_key& k ) { return uint64_t( k[1] ); }
+   };
+
+   template<>
+   struct secondary_key_traits<uint128_t> {
+      static constexpr uint32_t size = sizeof(uint128_t);
+      static uint128_t lowest() { return 0; }
+      static internal_use_do_not_use::secondary_key to_key( uint128_t v ) { return { 0, v }; }
+      static uint128_t from_key( const internal_use_do_not_use::secondary_key& k ) { return k[1]; }
+   };
+
+   template<>
+   struct secondary_key_traits<checksum256> {
+      static constexpr uint32_t size = 32;
+      static checksum256 lowest() { return checksum256(); }
+      static internal_use_do_not_use::secondary_key to_key( const checksum256& v ) { return v.get_array(); }
+      static checksum256 from_key( const internal_use_do_not_use::secondary_key& k ) { return checksum256( k ); }
+   };
+
+   template<name::raw IndexName, typename Extractor>
+   struct indexed_by {
+      static constexpr uint64_t index_name = static_cast<uint64_t>(IndexName);
+      typedef Extractor secondary_extractor_type;
+   };
+
+   template<class Class, typename Type, Type (Class::*PtrToMemberFunction)()const>
+   struct const_mem_fun {
+      typedef typename std::remove_reference<Type>::type result_type;
+
+      Type operator()( const Class& x ) const { return (x.*PtrToMemberFunction)(); }
+   };
+
+   template<name::raw TableName, typename T, typename... Indices>
+   class multi_index {
+   private:
+      static_assert( sizeof...(Indices) <= 16, "multi_index only supports a maximum of 16 secondary indices" );
+
+      constexpr static bool validate_table_name( name::raw n ) {
+         // Limit table names to 12 characters so that the last character (4 bits) can be used to distinguish between the secondary indices.
+         return ( static_cast<uint64_t>(n) & 0x000000000000000FULL ) == 0;
+      }
+      static_assert( validate_table_name(TableName), "multi_index does not support table names with a length greater than 12" );
+
+      enum next_primary_key_tags : uint64_t {
+         no_available_primary_key = static_cast<uint64_t>(-2), // Must be the smallest uint64_t value compared to all other tags
+         unset_next_primary_key = static_cast<uint64_t>(-1)
+      };
+
+      static constexpr size_t index_count = sizeof...(Indices);
+      using indices_type = std::tuple<Indices...>;
+
+      struct item : public T {
+         explicit item( const multi_index* idx ) : __idx(idx) {
+            std::fill( std::begin(__iters), std::end(__iters), -1 );
+         }
+         const multi_index* __idx;
+         int32_t            __primary_itr = -1;
+         int32_t            __iters[index_count + (index_count == 0)];
+      };
+
+      struct item_ptr {
+         item_ptr( std::unique_ptr<item>&& i, uint64_t pk, int32_t pitr )
+            : _item( std::move(i) ), _primary_key(pk), _primary_itr(pitr) {}
+         std::unique_ptr<item> _item;
+         uint64_t              _primary_key;
+         int32_t               _primary_itr;
+      };
+
+      name     _code;
+      uint64_t _scope;
+      mutable uint64_t _next_primary_key;
+      mutable std::vector<item_ptr> _items_vector;
+
+      template<size_t I>
+      using index_at = std::tuple_element_t<I, indices_type>;
+
+      template<size_t I>
+      using extractor_at = typename index_at<I>::secondary_extractor_type;
+
+      template<size_t I>
+      using secondary_at = std::decay_t<decltype( extractor_at<I>()( std::declval<const T&>() ) )>;
+
+      template<size_t I>
+      static constexpr uint64_t index_table_name() {
+         return ( static_cast<uint64_t>(TableName) & 0xFFFFFFFFFFFFFFF0ULL ) | ( I & 0x000000000000000FULL );
+      }
+
+      template<uint64_t IndexName, size_t I = 0>
+      static constexpr size_t index_position() {
+         if constexpr( I >= index_count ) {
+            return index_count;
+         } else if constexpr( index_at<I>::index_name == IndexName ) {
+            return I;
+         } else {
+            return index_position<IndexName, I + 1>();
+         }
+      }
+
+   public:
+      template<size_t Number>
+      struct index {
+      public:
+         using secondary_extractor_type = extractor_at<Number>;
+         using secondary_key_type = secondary_at<Number>;
+         using traits = secondary_key_traits<secondary_key_type>;
+
+         static constexpr uint64_t name() { return index_table_name<Number>(); }
+
+         struct const_iterator {
+         public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = const T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T*;
+            using reference = const T&;
+
+            friend bool operator == ( const const_iterator& a, const const_iterator& b ) { return a._item == b._item; }
+            friend bool operator != ( const const_iterator& a, const const_iterator& b ) { return a._item != b._item; }
+
+            const T& operator*() const { return *static_cast<const T*>(_item); }
+            const T* operator->() const { return static_cast<const T*>(_item); }
+
+            const_iterator operator++( int ) { const_iterator result(*this); ++(*this); return result; }
+            const_iterator operator--( int ) { const_iterator result(*this); --(*this); return result; }
+
+            const_iterator& operator++() {
+               using namespace internal_use_do_not_use;
+               check( _item != nullptr, "cannot increment end iterator" );
+               const auto* multidx = _idx->_multidx;
+               if( _item->__iters[Number] == -1 ) {
+                  secondary_key temp;
+                  auto idxitr = db_idx_find_primary( multidx->get_code().value, multidx->get_scope(), name(), &temp, _item->primary_key() );
+                  const_cast<item*>(_item)->__iters[Number] = idxitr;
+               }
+               uint64_t next_pk = 0;
+               auto next_itr = db_idx_next( _item->__iters[Number], &next_pk );
+               if( next_itr < 0 ) {
+                  _item = nullptr;
+                  return *this;
+               }
+               const T& obj = *multidx->find( next_pk );
+               auto& mi = const_cast<item&>( static_cast<const item&>(obj) );
+               mi.__iters[Number] = next_itr;
+               _item = &mi;
+               return *this;
+            }
+
+            const_iterator& operator--() {
+               using namespace internal_use_do_not_use;
+               const auto* multidx = _idx->_multidx;
+               uint64_t prev_pk = 0;
+               int32_t prev_itr = -1;
+               if( !_item ) {
+                  auto ei = db_idx_end( multidx->get_code().value, multidx->get_scope(), name() );
+                  check( ei != -1, "cannot decrement end iterator when the index is empty" );
+                  prev_itr = db_idx_previous( ei, &prev_pk );
+                  check( prev_itr >= 0, "cannot decrement end iterator when the index is empty" );
+               } else {
+                  if( _item->__iters[Number] == -1 ) {
+                     secondary_key temp;
+                     auto idxitr = db_idx_find_primary( multidx->get_code().value, multidx->get_scope(), name(), &temp, _item->primary_key() );
+                     const_cast<item*>(_item)->__iters[Number] = idxitr;
+                  }
+                  prev_itr = db_idx_previous( _item->__iters[Number], &prev_pk );
+                  check( prev_itr >= 0, "cannot decrement iterator at beginning of index" );
+               }
+               const T& obj = *multidx->find( prev_pk );
+               auto& mi = const_cast<item&>( static_cast<const item&>(obj) );
+               mi.__iters[Number] = prev_itr;
+               _item = &mi;
+               return *this;
+            }
+
+            const_iterator() = default;
+
+         private:
+            friend struct index;
+            const_iterator( const index* idx, const item* i = nullptr ) : _idx(idx), _item(i) {}
+
+            const index* _idx = nullptr;
+            const item*  _item = nullptr;
+         };
+
+         typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+         const_iterator cbegin() const { return lower_bound( traits::lowest() ); }
+         const_iterator begin() const  { return cbegin(); }
+         const_iterator cend() const   { return const_iterator( this ); }
+         const_iterator end() const    { return cend(); }
+         const_reverse_iterator crbegin() const { return std::make_reverse_iterator( cend() ); }
+         const_reverse_iterator rbegin() const  { return crbegin(); }
+         const_reverse_iterator crend() const   { return std::make_reverse_iterator( cbegin() ); }
+         const_reverse_iterator rend() const    { return crend(); }
+
+         const_iterator find( const secondary_key_type& secondary ) const {
+            auto lb = lower_bound( secondary );
+            auto e = cend();
+            if( lb == e ) return e;
+            if( secondary != secondary_extractor_type()( *lb ) ) return e;
+            return lb;
+         }
+
+         const T& get( const secondary_key_type& secondary, const char* error_msg = "unable to find secondary key" ) const {
+            auto result = find( secondary );
+            check( result != cend(), error_msg );
+            return *result;
+         }
+
+         const_iterator lower_bound( const secondary_key_type& secondary ) const {
+            return bound( secondary, &internal_use_do_not_use::db_idx_lowerbound );
+         }
+
+         const_iterator upper_bound( const secondary_key_type& secondary ) const {
+            return bound( secondary, &internal_use_do_not_use::db_idx_upperbound );
+         }
+
+         const_iterator iterator_to( const T& obj ) const {
+            const auto& objitem = static_cast<const item&>(obj);
+            check( objitem.__idx == _multidx, "object passed to iterator_to is not in multi_index" );
+            if( objitem.__iters[Number] == -1 ) {
+               internal_use_do_not_use::secondary_key temp;
+               auto idxitr = internal_use_do_not_use::db_idx_find_primary( _multidx->get_code().value, _multidx->get_scope(), name(), &temp, objitem.primary_key() );
+               check( idxitr >= 0, "object passed to iterator_to is not found in index" );
+               const_cast<item&>(objitem).__iters[Number] = idxitr;
+            }
+            return const_iterator( this, &objitem );
+         }
+
+         template<typename Lambda>
+         void modify( const_iterator itr, eosio::name payer, Lambda&& updater ) {
+            check( itr != cend(), "cannot pass end iterator to modify" );
+            _multidx->modify( *itr, payer, std::forward<Lambda>(updater) );
+         }
+
+         const_iterator erase( const_iterator itr ) {
+            check( itr != cend(), "cannot pass end iterator to erase" );
+            const auto& obj = *itr;
+            ++itr;
+            _multidx->erase( obj );
+            return itr;
+         }
+
+         eosio::name get_code() const  { return _multidx->get_code(); }
+         uint64_t    get_scope() const { return _multidx->get_scope(); }
+
+         static auto extract_secondary_key( const T& obj ) { return secondary_extractor_type()( obj ); }
+
+      private:
+         friend class multi_index;
+
+         index( multi_index* midx ) : _multidx(midx) {}
+
+         const_iterator bound( const secondary_key_type& secondary,
+                               int32_t (*fn)( uint64_t, uint64_t, uint64_t, internal_use_do_not_use::secondary_key*, uint64_t* ) ) const {
+            uint64_t primary = 0;
+            auto key = traits::to_key( secondary );
+            auto itr = fn( _multidx->get_code().value, _multidx->get_scope(), name(), &key, &primary );
+            if( itr < 0 ) return cend();
+            const T& obj = *_multidx->find( primary );
+            auto& mi = const_cast<item&>( static_cast<const item&>(obj) );
+            mi.__iters[Number] = itr;
+            return const_iterator( this, &mi );
+         }
+
+         multi_index* _multidx;
+      };
+
+      struct const_iterator {
+      public:
+         using iterator_category = std::bidirectional_iterator_tag;
+         using value_type = const T;
+         using difference_type = std::ptrdiff_t;
+         using pointer = const T*;
+         using reference = const T&;
+
+         friend bool operator == ( const const_iterator& a, const const_iterator& b ) { return a._item == b._item; }
+         friend bool operator != ( const const_iterator& a, const const_iterator& b ) { return a._item != b._item; }
+
+         const T& operator*() const { return *static_cast<const T*>(_item); }
+         const T* operator->() const { return static_cast<const T*>(_item); }
+
+         const_iterator operator++( int ) { const_iterator result(*this); ++(*this); return result; }
+         const_iterator operator--( int ) { const_iterator result(*this); --(*this); return result; }
+
+         const_iterator& operator++() {
+            check( _item != nullptr, "cannot increment end iterator" );
+            uint64_t next_pk;
+            auto next_itr = internal_use_do_not_use::db_next_i64( _item->__primary_itr, &next_pk );
+            if( next_itr < 0 )
+               _item = nullptr;
+            else
+               _item = &_multidx->load_object_by_primary_iterator( next_itr );
+            return *this;
+         }
+
+         const_iterator& operator--() {
+            uint64_t prev_pk;
+            int32_t prev_itr = -1;
+            if( !_item ) {
+               auto ei = internal_use_do_not_use::db_end_i64( _multidx->get_code().value, _multidx->get_scope(), static_cast<uint64_t>(TableName) );
+               check( ei != -1, "cannot decrement end iterator when the table is empty" );
+               prev_itr = internal_use_do_not_use::db_previous_i64( ei, &prev_pk );
+               check( prev_itr >= 0, "cannot decrement end iterator when the table is empty" );
+            } else {
+               prev_itr = internal_use_do_not_use::db_previous_i64( _item->__primary_itr, &prev_pk );
+               check( prev_itr >= 0, "cannot decrement iterator at beginning of table" );
+            }
+            _item = &_multidx->load_object_by_primary_iterator( prev_itr );
+            return *this;
+         }
+
+         const_iterator() = default;
+
+      private:
+         friend class multi_index;
+         const_iterator( const multi_index* mi, const item* i = nullptr ) : _multidx(mi), _item(i) {}
+
+         const multi_index* _multidx = nullptr;
+         const item*        _item = nullptr;
+      };
+
+      typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+      multi_index( name code, uint64_t scope )
+         : _code(code), _scope(scope), _next_primary_key(unset_next_primary_key) {}
+
+      multi_index( const multi_index& ) = delete;
+      multi_index& operator=( const multi_index& ) = delete;
+
+      name     get_code() const  { return _code; }
+      uint64_t get_scope() const { return _scope; }
+
+      const_iterator cbegin() const { return lower_bound( std::numeric_limits<uint64_t>::lowest() ); }
+      const_iterator begin() const  { return cbegin(); }
+      const_iterator cend() const   { return const_iterator( this ); }
+      const_iterator end() const    { return cend(); }
+      const_reverse_iterator crbegin() const { return std::make_reverse_iterator( cend() ); }
+      const_reverse_iterator rbegin() const  { return crbegin(); }
+      const_reverse_iterator crend() const   { return std::make_reverse_iterator( cbegin() ); }
+      const_reverse_iterator rend() const    { return crend(); }
+
+      const_iterator lower_bound( uint64_t primary ) const {
+         auto itr = internal_use_do_not_use::db_lowerbound_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
+         if( itr < 0 ) return end();
+         const auto& obj = load_object_by_primary_iterator( itr );
+         return const_iterator( this, &obj );
+      }
+
+      const_iterator upper_bound( uint64_t primary ) const {
+         auto itr = internal_use_do_not_use::db_upperbound_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
+         if( itr < 0 ) return end();
+         const auto& obj = load_object_by_primary_iterator( itr );
+         return const_iterator( this, &obj );
+      }
+
+      uint64_t available_primary_key() const {
+         if( _next_primary_key == unset_next_primary_key ) {
+            // This is the first time available_primary_key() is called for this multi_index instance.
+            if( begin() == end() ) {
+               _next_primary_key = 0;
+            } else {
+               auto itr = --end();
+               auto pk = itr->primary_key();
+               if( pk >= no_available_primary_key )
+                  _next_primary_key = no_available_primary_key;
+               else
+                  _next_primary_key = pk + 1;
+            }
+         }
+         check( _next_primary_key < no_available_primary_key, "next primary key in table is at autoincrement limit" );
+         return _next_primary_key;
+      }
+
+      template<name::raw IndexName>
+      auto get_index() {
+         constexpr size_t pos = index_position<static_cast<uint64_t>(IndexName)>();
+         static_assert( pos < index_count, "name provided is not the name of any secondary index within multi_index" );
+         return index<pos>( this );
+      }
+
+      template<name::raw IndexName>
+      auto get_index() const {
+         constexpr size_t pos = index_position<static_cast<uint64_t>(IndexName)>();
+         static_assert( pos < index_count, "name provided is not the name of any secondary index within multi_index" );
+         return index<pos>( const_cast<multi_index*>(this) );
+      }
+
+      const_iterator iterator_to( const T& obj ) const {
+         const auto& objitem = static_cast<const item&>(obj);
+         check( objitem.__idx == this, "object passed to iterator_to is not in multi_index" );
+         return const_iterator( this, &objitem );
+      }
+
+      template<typename Lambda>
+      const_iterator emplace( name payer, Lambda&& constructor ) {
+         using namespace internal_use_do_not_use;
+         check( _code == current_receiver(), "cannot create objects in table of another contract" );
+
+         auto i = std::make_unique<item>( this );
+         T& obj = static_cast<T&>( *i );
+         constructor( obj );
+
+         auto data = pack( obj );
+         auto pk = obj.primary_key();
+         i->__primary_itr = db_store_i64( _scope, static_cast<uint64_t>(TableName), payer.value, pk, data.data(), uint32_t( data.size() ) );
+
+         if( pk >= _next_primary_key )
+            _next_primary_key = ( pk >= no_available_primary_key ) ? no_available_primary_key : ( pk + 1 );
+
+         store_secondaries( *i, payer, std::make_index_sequence<index_count>{} );
+
+         const item* ptr = i.get();
+         auto pitr = i->__primary_itr;
+         _items_vector.emplace_back( std::move(i), pk, pitr );
+         return const_iterator( this, ptr );
+      }
+
+      template<typename Lambda>
+      void modify( const_iterator itr, name payer, Lambda&& updater ) {
+         check( itr != end(), "cannot pass end iterator to modify" );
+         modify( *itr, payer, std::forward<Lambda>(updater) );
+      }
+
+      template<typename Lambda>
+      void modify( const T& obj, name payer, Lambda&& updater ) {
+         using namespace internal_use_do_not_use;
+         check( _code == current_receiver(), "cannot modify objects in table of another contract" );
+
+         auto& mutableitem = const_cast<item&>( static_cast<const item&>(obj) );
+         check( mutableitem.__idx == this, "object passed to modify is not in this multi_index" );
+
+         auto secondary_keys = extract_secondaries( obj, std::make_index_sequence<index_count>{} );
+         auto pk = obj.primary_key();
+
+         T& mutableobj = static_cast<T&>( mutableitem );
+         updater( mutableobj );
+
+         check( pk == obj.primary_key(), "updater cannot change primary key when modifying an object" );
+
+         auto data = pack( obj );
+         db_update_i64( mutableitem.__primary_itr, payer.value, data.data(), uint32_t( data.size() ) );
+
+         if( pk >= _next_primary_key )
+            _next_primary_key = ( pk >= no_available_primary_key ) ? no_available_primary_key : ( pk + 1 );
+
+         update_secondaries( mutableitem, payer, secondary_keys, std::make_index_sequence<index_count>{} );
+      }
+
+      const T& get( uint64_t primary, const char* error_msg = "unable to find key" ) const {
+         auto result = find( primary );
+         check( result != end(), error_msg );
+         return *result;
+      }
+
+      const_iterator find( uint64_t primary ) const {
+         auto itr2 = std::find_if( _items_vector.rbegin(), _items_vector.rend(),
+                                   [&]( const item_ptr& ptr ) { return ptr._item->primary_key() == primary; } );
+         if( itr2 != _items_vector.rend() )
+            return iterator_to( *( itr2->_item ) );
+
+         auto itr = internal_use_do_not_use::db_find_i64( _code.value, _scope, static_cast<uint64_t>(TableName), primary );
+         if( itr < 0 ) return end();
+
+         const item& i = load_object_by_primary_iterator( itr );
+         return iterator_to( static_cast<const T&>(i) );
+      }
+
+      const_iterator require_find( uint64_t primary, const char* error_msg = "unable to find key" ) const {
+         auto result = find( primary );
+         check( result != end(), error_msg );
+         return result;
+      }
+
+      const_iterator erase( const_iterator itr ) {
+         check( itr != end(), "cannot pass end iterator to erase" );
+         const auto& obj = *itr;
+         ++itr;
+         erase( obj );
+         return itr;
+      }
+
+      void erase( const T& obj ) {
+         using namespace internal_use_do_not_use;
+         const auto& objitem = static_cast<const item&>(obj);
+         check( objitem.__idx == this, "object passed to erase is not in multi_index" );
+         check( _code == current_receiver(), "cannot erase objects in table of another contract" );
+
+         auto pk = objitem.primary_key();
+         remove_secondaries( objitem, std::make_index_sequence<index_count>{} );
+         db_remove_i64( objitem.__primary_itr );
+
+         auto itr2 = std::find_if( _items_vector.rbegin(), _items_vector.rend(),
+                                   [&]( const item_ptr& ptr ) { return ptr._item.get() == &objitem; } );
+         check( itr2 != _items_vector.rend(), "attempt to remove object that was not in multi_index" );
+         _items_vector.erase( --( itr2.base() ) );
+         (void)pk;
+      }
+
+   private:
+      friend struct const_iterator;
+
+      const item& load_object_by_primary_iterator( int32_t itr ) const {
+         using namespace internal_use_do_not_use;
+
+         auto itr2 = std::find_if( _items_vector.rbegin(), _items_vector.rend(),
+                                   [&]( const item_ptr& ptr ) { return ptr._primary_itr == itr; } );
+         if( itr2 != _items_vector.rend() )
+            return *itr2->_item;
+
+         auto size = db_get_i64( itr, nullptr, 0 );
+         check( size >= 0, "error reading iterator" );
+         std::vector<char> buffer( size );
+         db_get_i64( itr, buffer.data(), uint32_t( size ) );
+
+         auto i = std::make_unique<item>( this );
+         datastream<const char*> ds( buffer.data(), buffer.size() );
+         ds >> static_cast<T&>( *i );
+         i->__primary_itr = itr;
+
+         const item* ptr = i.get();
+         auto pk = i->primary_key();
+         _items_vector.emplace_back( std::move(i), pk, itr );
+         return *ptr;
+      }
+
+      template<size_t... I>
+      void store_secondaries( item& i, [[maybe_unused]] name payer, std::index_sequence<I...> ) {
+         ( store_secondary<I>( i, payer ), ... );
+      }
+
+      template<size_t I>
+      void store_secondary( item& i, name payer ) {
+         using traits = secondary_key_traits<secondary_at<I>>;
+         auto key = traits::to_key( extractor_at<I>()( static_cast<const T&>(i) ) );
+         i.__iters[I] = internal_use_do_not_use::db_idx_store( _scope, index_table_name<I>(), payer.value,
+                                                               i.primary_key(), key, traits::size );
+      }
+
+      template<size_t... I>
+      auto extract_secondaries( const T& obj, std::index_sequence<I...> ) const {
+         return std::make_tuple( extractor_at<I>()( obj )... );
+      }
+
+      template<typename Tuple, size_t... I>
+      void update_secondaries( item& i, [[maybe_unused]] name payer, const Tuple& old_keys, std::index_sequence<I...> ) {
+         ( update_secondary<I>( i, payer, std::get<I>( old_keys ) ), ... );
+      }
+
+      template<size_t I, typename Key>
+      void update_secondary( item& i, name payer, const Key& old_key ) {
+         using namespace internal_use_do_not_use;
+         using traits = secondary_key_traits<secondary_at<I>>;
+         auto new_key = extractor_at<I>()( static_cast<const T&>(i) );
+         if( new_key != old_key || payer != same_payer ) {
+            if( i.__iters[I] == -1 ) {
+               secondary_key temp;
+               i.__iters[I] = db_idx_find_primary( _code.value, _scope, index_table_name<I>(), &temp, i.primary_key() );
+            }
+            db_idx_update( i.__iters[I], payer.value, traits::to_key( new_key ) );
+         }
+      }
+
+      template<size_t... I>
+      void remove_secondaries( const item& i, std::index_sequence<I...> ) {
+         ( remove_secondary<I>( i ), ... );
+      }
+
+      template<size_t I>
+      void remove_secondary( const item& i ) {
+         using namespace internal_use_do_not_use;
+         auto itr = i.__iters[I];
+         if( itr == -1 ) {
+            secondary_key temp;
+            itr = db_idx_find_primary( _code.value, _scope, index_table_name<I>(), &temp, i.primary_key() );
+         }
+         if( itr >= 0 ) {
+            db_idx_remove( itr );
+         }
+      }
+   };
+
+} // namespace eosio
@@ -0,0 +1,52 @@
+/**
+ *  Host stand-in for <eosio/print.hpp>. Output goes to the in-memory chain's
+ *  console buffer for the running action.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "name.hpp"
+#include "symbol.hpp"
+#include "asset.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+   namespace internal_use_do_not_use {
+      void prints_l( const char* s, uint32_t len );
+   }
+
+   inline void printl( const char* s, size_t len ) {
+      internal_use_do_not_use::prints_l( s, uint32_t( len ) );
+   }
+
+   inline void print( std::string_view s ) { printl( s.data(), s.size() ); }
+   inline void print( const char* s )      { print( std::string_view( s ) ); }
+   inline void print( const std::string& s ) { print( std::string_view( s ) ); }
+   inline void print( char c )             { printl( &c, 1 ); }
+   inline void print( bool b )             { print( b ? "true" : "false" ); }
+   inline void print( name n )             { print( n.to_string() ); }
+   inline void print( symbol_code s )      { print( s.to_string() ); }
+   inline void print( symbol s )           { print( s.to_string() ); }
+   inline void print( const asset& a )     { print( a.to_string() ); }
+   inline void print( const time_point& t ) { print( std::to_string( t.time_since_epoch().count() ) ); }
+
+   template<typename T, std::enable_if_t<std::is_integral<T>::value>* = nullptr>
+   inline void print( T num ) {
+      print( std::to_string( num ) );
+   }
+
+   template<typename Arg, typename Arg2, typename... Args>
+   void print( Arg&& a, Arg2&& b, Args&&... args ) {
+      print( std::forward<Arg>( a ) );
+      print( std::forward<Arg2>( b ), std::forward<Args>( args )... );
+   }
+
+   template<typename... Args>
+   void print_f( Args&&... args ) { print( std::forward<Args>( args )... ); }
+
+} // namespace eosio
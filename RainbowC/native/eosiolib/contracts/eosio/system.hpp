@@ -0,0 +1,20 @@
+/**
+ *  Host stand-in for <eosio/system.hpp>.
+ */
+#pragma once
+
+#include "../../capi/eosio/action.h"
+#include "name.hpp"
+#include "time.hpp"
+
+namespace eosio {
+
+   inline time_point current_time_point() {
+      return time_point( microseconds( static_cast<int64_t>( ::current_time() ) ) );
+   }
+
+   inline name current_receiver() {
+      return name( ::current_receiver() );
+   }
+
+} // namespace eosio
@@ -0,0 +1,754 @@
+/**
+ *  Replays a log of rainbow contract actions against the in-memory chain stand-in and
+ *  reports throughput, the cost of each action type and the hash of the final state.
+ *
+ *  Logs are JSON lines, one action per line, e.g.
+ *    {"time":"2021-01-01T00:00:00","action":"transfer","auth":["alice"],
+ *     "data":{"from":"alice","to":"bob","quantity":"1.0000 RBW","memo":""}}
+ *  where `time` (ISO string or seconds since the epoch) is optional and keeps the clock
+ *  of the previous action when left out. `--write-binary` converts a log to the binary
+ *  form read with `--binary`: per action a 32-bit length and the packed log_record.
+ *
+ *  With `--threads N` the log is split into partitions whose actions touch disjoint table
+ *  scopes (accounts rows by owner; stat, configs, stakes and the other token tables by
+ *  symbol; stake token balances by contract and owner), and the partitions run on N
+ *  chains in parallel, each in log order. No row is written by two partitions, so the
+ *  summed state hash of the chains equals that of a serial run; `--verify` replays the
+ *  log both ways and fails if the hashes differ. A serial replay streams the log; a
+ *  parallel one holds it in memory.
+ *
+ *  Every account named in the log is created up front. Other token contracts are not
+ *  replayed: inline actions are recorded only, and `setstake` seeds a zero stake token
+ *  balance for the issuer when there is none.
+ */
+#include <rainbow.hpp>
+#include <chain.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace eosio;
+
+namespace {
+
+   // ---- JSON ----
+
+   struct json_value {
+      enum kind_t { null, boolean, number, string, array, object } kind = null;
+      bool                                            flag = false;
+      std::string                                     text;    // string value, or number as written
+      std::vector<json_value>                         items;
+      std::vector<std::pair<std::string, json_value>> fields;
+
+      const json_value* find( const std::string& key ) const {
+         for( const auto& f : fields ) {
+            if( f.first == key ) return &f.second;
+         }
+         return nullptr;
+      }
+
+      const json_value& at( const std::string& key ) const {
+         auto v = find( key );
+         if( !v ) throw std::runtime_error( "missing field \"" + key + "\"" );
+         return *v;
+      }
+   };
+
+   class json_parser {
+   public:
+      explicit json_parser( const std::string& s ) : _s( s ) {}
+
+      json_value parse() {
+         auto v = value();
+         skip_space();
+         if( _pos != _s.size() ) fail( "trailing characters" );
+         return v;
+      }
+
+   private:
+      [[noreturn]] void fail( const char* what ) const {
+         throw std::runtime_error( std::string( "invalid JSON: " ) + what + " at column " + std::to_string( _pos + 1 ) );
+      }
+
+      void skip_space() {
+         while( _pos < _s.size() && std::strchr( " \t\r\n", _s[_pos] ) ) ++_pos;
+      }
+
+      void expect( char c ) {
+         skip_space();
+         if( _pos >= _s.size() || _s[_pos] != c ) fail( "unexpected character" );
+         ++_pos;
+      }
+
+      bool consume( const char* word ) {
+         size_t n = std::strlen( word );
+         if( _s.compare( _pos, n, word ) != 0 ) return false;
+         _pos += n;
+         return true;
+      }
+
+      json_value value() {
+         skip_space();
+         if( _pos >= _s.size() ) fail( "unexpected end" );
+         json_value v;
+         char c = _s[_pos];
+         if( c == '{' ) {
+            v.kind = json_value::object;
+            ++_pos;
+            skip_space();
+            if( _pos < _s.size() && _s[_pos] == '}' ) { ++_pos; return v; }
+            do {
+               skip_space();
+               auto key = string_literal();
+               expect( ':' );
+               v.fields.emplace_back( std::move( key ), value() );
+               skip_space();
+            } while( _pos < _s.size() && _s[_pos] == ',' && ++_pos );
+            expect( '}' );
+         } else if( c == '[' ) {
+            v.kind = json_value::array;
+            ++_pos;
+            skip_space();
+            if( _pos < _s.size() && _s[_pos] == ']' ) { ++_pos; return v; }
+            do {
+               v.items.push_back( value() );
+               skip_space();
+            } while( _pos < _s.size() && _s[_pos] == ',' && ++_pos );
+            expect( ']' );
+         } else if( c == '"' ) {
+            v.kind = json_value::string;
+            v.text = string_literal();
+         } else if( consume( "true" ) || consume( "false" ) ) {
+            v.kind = json_value::boolean;
+            v.flag = _s[_pos - 1] == 'e' && _s[_pos - 2] == 'u';
+         } else if( consume( "null" ) ) {
+            v.kind = json_value::null;
+         } else {
+            size_t start = _pos;
+            while( _pos < _s.size() && std::strchr( "+-0123456789.eE", _s[_pos] ) ) ++_pos;
+            if( _pos == start ) fail( "unexpected character" );
+            v.kind = json_value::number;
+            v.text = _s.substr( start, _pos - start );
+         }
+         return v;
+      }
+
+      std::string string_literal() {
+         if( _pos >= _s.size() || _s[_pos] != '"' ) fail( "expected string" );
+         ++_pos;
+         std::string out;
+         while( true ) {
+            if( _pos >= _s.size() ) fail( "unterminated string" );
+            char c = _s[_pos++];
+            if( c == '"' ) return out;
+            if( c != '\\' ) { out += c; continue; }
+            if( _pos >= _s.size() ) fail( "unterminated string" );
+            c = _s[_pos++];
+            switch( c ) {
+               case 'b': out += '\b'; break;
+               case 'f': out += '\f'; break;
+               case 'n': out += '\n'; break;
+               case 'r': out += '\r'; break;
+               case 't': out += '\t'; break;
+               case 'u': append_utf8( out, code_point() ); break;
+               default:  out += c;
+            }
+         }
+      }
+
+      uint32_t hex4() {
+         if( _pos + 4 > _s.size() ) fail( "bad escape" );
+         uint32_t cp = std::stoul( _s.substr( _pos, 4 ), nullptr, 16 );
+         _pos += 4;
+         return cp;
+      }
+
+      uint32_t code_point() {
+         uint32_t cp = hex4();
+         if( cp >= 0xD800 && cp < 0xDC00 && consume( "\\u" ) ) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (hex4() - 0xDC00);
+         }
+         return cp;
+      }
+
+      static void append_utf8( std::string& out, uint32_t cp ) {
+         if( cp < 0x80 ) {
+            out += char( cp );
+         } else if( cp < 0x800 ) {
+            out += char( 0xC0 | cp >> 6 );
+            out += char( 0x80 | (cp & 0x3F) );
+         } else if( cp < 0x10000 ) {
+            out += char( 0xE0 | cp >> 12 );
+            out += char( 0x80 | (cp >> 6 & 0x3F) );
+            out += char( 0x80 | (cp & 0x3F) );
+         } else {
+            out += char( 0xF0 | cp >> 18 );
+            out += char( 0x80 | (cp >> 12 & 0x3F) );
+            out += char( 0x80 | (cp >> 6 & 0x3F) );
+            out += char( 0x80 | (cp & 0x3F) );
+         }
+      }
+
+      const std::string& _s;
+      size_t             _pos = 0;
+   };
+
+   // ---- action arguments from JSON ----
+
+   const std::string& as_string( const json_value& v ) {
+      if( v.kind != json_value::string ) throw std::runtime_error( "expected a string" );
+      return v.text;
+   }
+
+   void from_json( const json_value& v, std::string& out ) { out = as_string( v ); }
+   void from_json( const json_value& v, name& out )        { out = name( as_string( v ) ); }
+   void from_json( const json_value& v, symbol_code& out ) { out = symbol_code( as_string( v ) ); }
+
+   void from_json( const json_value& v, bool& out ) {
+      if( v.kind != json_value::boolean ) throw std::runtime_error( "expected true or false" );
+      out = v.flag;
+   }
+
+   void from_json( const json_value& v, uint32_t& out ) {
+      if( v.kind != json_value::number ) throw std::runtime_error( "expected a number" );
+      out = uint32_t( std::stoul( v.text ) );
+   }
+
+   void from_json( const json_value& v, uint16_t& out ) {
+      uint32_t wide;
+      from_json( v, wide );
+      if( wide > 0xffff ) throw std::runtime_error( "number out of range" );
+      out = uint16_t( wide );
+   }
+
+   /// "1.0000 RBW": the digits after the point give the precision
+   void from_json( const json_value& v, asset& out ) {
+      const auto& s = as_string( v );
+      auto space = s.find( ' ' );
+      if( space == std::string::npos ) throw std::runtime_error( "bad asset \"" + s + "\"" );
+      std::string digits = s.substr( 0, space );
+      bool negative = !digits.empty() && digits[0] == '-';
+      if( negative ) digits.erase( 0, 1 );
+      auto point = digits.find( '.' );
+      uint8_t precision = point == std::string::npos ? 0 : uint8_t( digits.size() - point - 1 );
+      if( point != std::string::npos ) digits.erase( point, 1 );
+      if( digits.empty() || digits.find_first_not_of( "0123456789" ) != std::string::npos ) {
+         throw std::runtime_error( "bad asset \"" + s + "\"" );
+      }
+      int64_t amount = std::stoll( digits );
+      out = asset( negative ? -amount : amount, symbol( symbol_code( s.substr( space + 1 ) ), precision ) );
+   }
+
+   /// "2021-01-01T00:00:00" or seconds since the epoch
+   void from_json( const json_value& v, time_point_sec& out ) {
+      out = v.kind == json_value::number
+               ? time_point_sec( uint32_t( std::stoul( v.text ) ) )
+               : time_point_sec( time_point::from_iso_string( as_string( v ) ) );
+   }
+
+   void from_json( const json_value& v, token::transfer_args& out ) {
+      from_json( v.at( "from" ), out.from );
+      from_json( v.at( "to" ), out.to );
+      from_json( v.at( "quantity" ), out.quantity );
+      from_json( v.at( "memo" ), out.memo );
+   }
+
+   template<typename T>
+   void from_json( const json_value& v, std::vector<T>& out ) {
+      if( v.kind != json_value::array ) throw std::runtime_error( "expected an array" );
+      out.resize( v.items.size() );
+      for( size_t i = 0; i < out.size(); ++i ) from_json( v.items[i], out[i] );
+   }
+
+   // ---- log records ----
+
+   struct log_record {
+      uint32_t           time;      // seconds since the epoch, 0 for the time of the record before
+      name               action;
+      std::vector<name>  auths;
+      std::vector<char>  data;      // packed action arguments
+   };
+
+   /// scopes an action reads or writes, and the accounts it names
+   struct scope_set {
+      std::vector<std::tuple<uint64_t, uint64_t, uint64_t>> scopes;  // (code, table group, scope)
+      std::vector<name>                                     accounts;
+
+      void token( const symbol_code& sc ) { scopes.emplace_back( 0, "stat"_n.value, sc.raw() ); }
+      void balance( const name& owner ) {
+         scopes.emplace_back( 0, "accounts"_n.value, owner.value );
+         accounts.push_back( owner );
+      }
+      void external( const name& contract, const name& owner ) {
+         scopes.emplace_back( contract.value, "accounts"_n.value, owner.value );
+      }
+      void account( const name& n ) { accounts.push_back( n ); }
+   };
+
+   struct action_handler {
+      std::function<std::vector<char>( const json_value& )>            encode;
+      std::function<void( const std::vector<char>&, scope_set& )>       scopes;
+      std::function<void( native::chain&, const std::vector<char>& )>  prepare;
+      std::function<void( token&, const std::vector<char>& )>          apply;
+   };
+
+   /// `scopes` is called with the unpacked arguments as a std::tuple<Args...>
+   template<typename... Args, typename F>
+   action_handler make_handler( void (token::*fn)( const Args&... ),
+                                std::array<const char*, sizeof...(Args)> fields, F scopes ) {
+      action_handler h;
+      h.encode = [fields]( const json_value& data ) {
+         std::tuple<Args...> args;
+         size_t i = 0;
+         std::apply( [&]( auto&... a ) { ( from_json( data.at( fields[i++] ), a ), ... ); }, args );
+         return eosio::pack( args );
+      };
+      h.scopes = [scopes]( const std::vector<char>& data, scope_set& s ) {
+         scopes( eosio::unpack<std::tuple<Args...>>( data ), s );
+      };
+      h.apply = [fn]( token& tk, const std::vector<char>& data ) {
+         auto args = eosio::unpack<std::tuple<Args...>>( data );
+         std::apply( [&]( const auto&... a ) { (tk.*fn)( a... ); }, args );
+      };
+      return h;
+   }
+
+   const std::map<name, action_handler>& handlers() {
+      static const std::map<name, action_handler> table = [] {
+         std::map<name, action_handler> t;
+         t["create"_n] = make_handler( &token::create,
+            { "issuer", "maximum_supply", "membership_mgr", "withdrawal_mgr", "withdraw_to", "freeze_mgr",
+              "redeem_locked_until", "config_locked_until" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<1>( a ).symbol.code() );
+               // create recomputes circulating supply from these two balances
+               s.balance( std::get<0>( a ) );
+               s.balance( std::get<4>( a ) );
+               s.account( std::get<2>( a ) );
+               s.account( std::get<3>( a ) );
+               s.account( std::get<5>( a ) );
+            } );
+         t["approve"_n] = make_handler( &token::approve, { "symbolcode", "reject_and_clear" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ) ); } );
+         t["setstake"_n] = make_handler( &token::setstake,
+            { "issuer", "token_bucket", "stake_per_bucket", "stake_token_contract", "stake_to", "deferred",
+              "proportional", "memo" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<1>( a ).symbol.code() );
+               s.balance( std::get<0>( a ) );
+               s.account( std::get<3>( a ) );
+               s.account( std::get<4>( a ) );
+               s.external( std::get<3>( a ), std::get<0>( a ) );
+               s.external( std::get<3>( a ), std::get<4>( a ) );
+            } );
+         t["setstake"_n].prepare = []( native::chain& c, const std::vector<char>& data ) {
+            auto [issuer, bucket, per_bucket, contract, stake_to, deferred, proportional, memo] =
+               eosio::unpack<std::tuple<name, asset, asset, name, name, bool, bool, std::string>>( data );
+            auto sym = per_bucket.symbol;
+            if( !c.get_row<asset>( contract, issuer.value, "accounts"_n, sym.code().raw() ) ) {
+               c.put_row( contract, issuer.value, "accounts"_n, sym.code().raw(), asset( 0, sym ), issuer );
+            }
+         };
+         t["issue"_n] = make_handler( &token::issue, { "quantity", "memo" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ).symbol.code() ); } );
+         t["retire"_n] = make_handler( &token::retire, { "owner", "quantity", "memo" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<1>( a ).symbol.code() );
+               s.balance( std::get<0>( a ) );
+            } );
+         t["transfer"_n] = make_handler( &token::transfer, { "from", "to", "quantity", "memo" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<2>( a ).symbol.code() );
+               s.balance( std::get<0>( a ) );
+               s.balance( std::get<1>( a ) );
+            } );
+         t["transfers"_n] = make_handler( &token::transfers, { "batch" },
+            []( const auto& a, scope_set& s ) {
+               for( const auto& x : std::get<0>( a ) ) {
+                  s.token( x.quantity.symbol.code() );
+                  s.balance( x.from );
+                  s.balance( x.to );
+               }
+            } );
+         t["open"_n] = make_handler( &token::open, { "owner", "symbolcode", "ram_payer" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<1>( a ) );
+               s.balance( std::get<0>( a ) );
+               s.account( std::get<2>( a ) );
+            } );
+         t["close"_n] = make_handler( &token::close, { "owner", "symbolcode" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<1>( a ) );
+               s.balance( std::get<0>( a ) );
+            } );
+         t["freeze"_n] = make_handler( &token::freeze, { "symbolcode", "freeze", "memo" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ) ); } );
+         t["setoption"_n] = make_handler( &token::setoption, { "symbolcode", "option", "enabled" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ) ); } );
+         t["setlimit"_n] = make_handler( &token::setlimit, { "symbolcode", "window", "max_transfers", "max_volume" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ) ); } );
+         t["setfee"_n] = make_handler( &token::setfee,
+            { "symbolcode", "basis_points", "max_fee", "treasury", "shards" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<0>( a ) );
+               s.balance( std::get<3>( a ) );
+            } );
+         t["setallowance"_n] = make_handler( &token::setallowance, { "owner", "spender", "quantity", "expiry" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<2>( a ).symbol.code() );
+               s.account( std::get<1>( a ) );
+            } );
+         t["transferfrom"_n] = make_handler( &token::transferfrom, { "spender", "from", "to", "quantity", "memo" },
+            []( const auto& a, scope_set& s ) {
+               s.token( std::get<3>( a ).symbol.code() );
+               s.account( std::get<0>( a ) );
+               s.balance( std::get<1>( a ) );
+               s.balance( std::get<2>( a ) );
+            } );
+         t["pullmany"_n] = make_handler( &token::pullmany, { "spender", "batch" },
+            []( const auto& a, scope_set& s ) {
+               s.account( std::get<0>( a ) );
+               for( const auto& x : std::get<1>( a ) ) {
+                  s.token( x.quantity.symbol.code() );
+                  s.balance( x.from );
+                  s.balance( x.to );
+               }
+            } );
+         // the treasury credited is not an argument, but setfee already joined its balance to the token
+         t["sweepfees"_n] = make_handler( &token::sweepfees, { "symbolcode", "limit" },
+            []( const auto& a, scope_set& s ) { s.token( std::get<0>( a ) ); } );
+         return t;
+      }();
+      return table;
+   }
+
+   const action_handler& handler_for( const name& action ) {
+      auto h = handlers().find( action );
+      if( h == handlers().end() ) throw std::runtime_error( "unsupported action " + action.to_string() );
+      return h->second;
+   }
+
+   log_record record_from_json( const std::string& line ) {
+      auto v = json_parser( line ).parse();
+      log_record r{ 0, name(), {}, {} };
+      if( auto t = v.find( "time" ) ) {
+         r.time = t->kind == json_value::number
+                     ? uint32_t( std::stoul( t->text ) )
+                     : time_point::from_iso_string( as_string( *t ) ).sec_since_epoch();
+      }
+      from_json( v.at( "action" ), r.action );
+      if( auto a = v.find( "auth" ) ) from_json( *a, r.auths );
+      r.data = handler_for( r.action ).encode( v.at( "data" ) );
+      return r;
+   }
+
+   /// calls `fn` with each record of the log, in order; records without a time get that
+   /// of the record before, so a record replays at the same time in any partition
+   void read_log( const std::string& path, bool binary, const std::function<void( log_record&& )>& next ) {
+      std::ifstream in( path, binary ? std::ios::binary : std::ios::in );
+      if( !in ) throw std::runtime_error( "cannot open " + path );
+      uint32_t time = 0;
+      auto fn = [&]( log_record&& r ) {
+         if( r.time == 0 ) r.time = time;
+         time = r.time;
+         next( std::move( r ) );
+      };
+      if( binary ) {
+         uint32_t size;
+         std::vector<char> buf;
+         while( in.read( reinterpret_cast<char*>( &size ), sizeof( size ) ) ) {
+            buf.resize( size );
+            if( !in.read( buf.data(), size ) ) throw std::runtime_error( "truncated binary log" );
+            fn( eosio::unpack<log_record>( buf ) );
+         }
+         return;
+      }
+      std::string line;
+      for( uint64_t n = 1; std::getline( in, line ); ++n ) {
+         if( line.find_first_not_of( " \t\r" ) == std::string::npos ) continue;
+         try {
+            fn( record_from_json( line ) );
+         } catch( const std::exception& e ) {
+            throw std::runtime_error( path + ":" + std::to_string( n ) + ": " + e.what() );
+         }
+      }
+   }
+
+   // ---- execution ----
+
+   struct action_cost {
+      uint64_t count = 0;
+      uint64_t failed = 0;
+      uint64_t nanoseconds = 0;
+      uint64_t db_reads = 0;
+      uint64_t db_writes = 0;
+
+      action_cost& operator += ( const action_cost& o ) {
+         count += o.count;  failed += o.failed;  nanoseconds += o.nanoseconds;
+         db_reads += o.db_reads;  db_writes += o.db_writes;
+         return *this;
+      }
+   };
+
+   /// one chain with the contract deployed, applying records in the order given
+   struct replayer {
+      native::chain                  c;
+      token                          tk;
+      std::map<name, action_cost>    costs;
+      std::vector<std::string>       errors;   // first few failures
+
+      replayer( const name& self, const std::set<name>& accounts )
+         : tk( self, self, datastream<const char*>( nullptr, 0 ) ) {
+         for( const auto& n : accounts ) c.create_account( n );
+         c.create_account( self );
+      }
+
+      void apply( const log_record& r ) {
+         const auto& h = handler_for( r.action );
+         if( r.time != 0 ) c.set_time( time_point( seconds( r.time ) ) );
+         if( h.prepare ) h.prepare( c, r.data );
+         auto start = std::chrono::steady_clock::now();
+         auto result = c.push( tk.get_self(), r.auths, [&]{ h.apply( tk, r.data ); } );
+         auto elapsed = std::chrono::steady_clock::now() - start;
+         auto& cost = costs[r.action];
+         cost.count++;
+         cost.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count();
+         const auto& s = result.stats;
+         cost.db_reads  += s.count( native::db_op::find ) + s.count( native::db_op::get ) + s.count( native::db_op::next );
+         cost.db_writes += s.count( native::db_op::modify ) + s.count( native::db_op::emplace ) + s.count( native::db_op::erase );
+         if( !result.ok ) {
+            cost.failed++;
+            if( errors.size() < 10 ) errors.push_back( r.action.to_string() + ": " + result.error );
+         }
+      }
+   };
+
+   struct replay_result {
+      uint64_t                     actions = 0;
+      double                       seconds = 0;
+      uint64_t                     hash = 0;
+      std::map<name, action_cost>  costs;
+      std::vector<std::string>     errors;
+   };
+
+   void collect( replay_result& out, const replayer& r ) {
+      out.hash += r.c.state_hash();
+      for( const auto& [action, cost] : r.costs ) out.costs[action] += cost;
+      for( const auto& e : r.errors ) {
+         if( out.errors.size() < 10 ) out.errors.push_back( e );
+      }
+   }
+
+   /// every account named by the log, so serial and parallel chains see the same ones
+   void add_accounts( std::set<name>& accounts, const log_record& r, scope_set& s ) {
+      handler_for( r.action ).scopes( r.data, s );
+      accounts.insert( s.accounts.begin(), s.accounts.end() );
+      accounts.insert( r.auths.begin(), r.auths.end() );
+   }
+
+   replay_result replay_serial( const name& self, const std::string& path, bool binary,
+                                const std::set<name>& accounts ) {
+      replay_result out;
+      replayer r( self, accounts );
+      r.c.make_current();
+      auto start = std::chrono::steady_clock::now();
+      read_log( path, binary, [&]( log_record&& rec ) {
+         r.apply( rec );
+         out.actions++;
+      });
+      out.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+      collect( out, r );
+      return out;
+   }
+
+   struct partition_plan {
+      std::vector<std::vector<uint64_t>> workers;      // record indexes per worker, in log order
+      uint64_t                           partitions = 0;
+      uint64_t                           largest = 0;  // actions in the largest partition
+   };
+
+   /// groups records that share a scope (union-find over scopes), then spreads the groups
+   /// over `threads` workers, largest group first onto the least loaded worker
+   partition_plan plan_partitions( const std::vector<log_record>& records, uint32_t threads ) {
+      std::map<std::tuple<uint64_t, uint64_t, uint64_t>, uint64_t> scope_ids;
+      std::vector<uint64_t> parent;
+      auto find = [&]( uint64_t x ) {
+         while( parent[x] != x ) x = parent[x] = parent[parent[x]];
+         return x;
+      };
+      std::vector<uint64_t> first_scope( records.size() );
+      for( size_t i = 0; i < records.size(); ++i ) {
+         scope_set s;
+         handler_for( records[i].action ).scopes( records[i].data, s );
+         uint64_t root = UINT64_MAX;
+         for( const auto& key : s.scopes ) {
+            auto id = scope_ids.emplace( key, parent.size() );
+            if( id.second ) parent.push_back( parent.size() );
+            auto x = find( id.first->second );
+            if( root == UINT64_MAX ) {
+               root = x;
+            } else if( x != root ) {
+               parent[x] = root;
+            }
+         }
+         first_scope[i] = root;
+      }
+
+      std::map<uint64_t, std::vector<uint64_t>> groups;
+      for( size_t i = 0; i < records.size(); ++i ) {
+         groups[find( first_scope[i] )].push_back( i );
+      }
+      std::vector<const std::vector<uint64_t>*> by_size;
+      for( const auto& g : groups ) by_size.push_back( &g.second );
+      std::stable_sort( by_size.begin(), by_size.end(), []( auto a, auto b ) { return a->size() > b->size(); } );
+
+      partition_plan plan;
+      plan.partitions = groups.size();
+      plan.largest = by_size.empty() ? 0 : by_size.front()->size();
+      plan.workers.resize( threads );
+      for( const auto* g : by_size ) {
+         auto w = std::min_element( plan.workers.begin(), plan.workers.end(),
+                                    []( const auto& a, const auto& b ) { return a.size() < b.size(); } );
+         w->insert( w->end(), g->begin(), g->end() );
+      }
+      for( auto& w : plan.workers ) std::sort( w.begin(), w.end() );
+      return plan;
+   }
+
+   replay_result replay_parallel( const name& self, const std::vector<log_record>& records,
+                                  const partition_plan& plan, const std::set<name>& accounts ) {
+      replay_result out;
+      out.actions = records.size();
+      std::vector<std::unique_ptr<replayer>> chains;
+      for( size_t i = 0; i < plan.workers.size(); ++i ) {
+         chains.push_back( std::make_unique<replayer>( self, accounts ) );
+      }
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for( size_t i = 0; i < plan.workers.size(); ++i ) {
+         threads.emplace_back( [&, i]{
+            auto& r = *chains[i];
+            r.c.make_current();
+            for( auto index : plan.workers[i] ) r.apply( records[index] );
+         });
+      }
+      for( auto& t : threads ) t.join();
+      out.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+      for( const auto& r : chains ) collect( out, *r );
+      return out;
+   }
+
+   void report( const char* label, const replay_result& r ) {
+      std::printf( "%s: %llu actions in %.3f s, %.0f actions/s\n", label, (unsigned long long)r.actions,
+                   r.seconds, r.seconds > 0 ? r.actions / r.seconds : 0.0 );
+      std::printf( "  %-12s %10s %8s %10s %10s %10s\n", "action", "count", "failed", "avg us", "db reads", "db writes" );
+      for( const auto& [action, c] : r.costs ) {
+         std::printf( "  %-12s %10llu %8llu %10.2f %10.1f %10.1f\n", action.to_string().c_str(),
+                      (unsigned long long)c.count, (unsigned long long)c.failed,
+                      c.nanoseconds / 1000.0 / c.count, double( c.db_reads ) / c.count,
+                      double( c.db_writes ) / c.count );
+      }
+      for( const auto& e : r.errors ) std::printf( "  failed %s\n", e.c_str() );
+      std::printf( "  state hash %016llx\n", (unsigned long long)r.hash );
+   }
+
+   int usage() {
+      std::fprintf( stderr,
+         "usage: rainbow_replay [--contract NAME] [--threads N] [--verify] [--binary]\n"
+         "                      [--write-binary FILE] LOG\n" );
+      return 2;
+   }
+
+} // namespace
+
+int main( int argc, char** argv ) {
+   name self = "rainbowtoken"_n;
+   uint32_t threads = 1;
+   bool verify = false;
+   bool binary = false;
+   std::string write_binary;
+   std::string path;
+   for( int i = 1; i < argc; ++i ) {
+      std::string arg = argv[i];
+      bool has_value = i + 1 < argc;
+      if( arg == "--contract" && has_value ) {
+         self = name( std::string( argv[++i] ) );
+      } else if( arg == "--threads" && has_value ) {
+         threads = std::max( 1, std::atoi( argv[++i] ) );
+      } else if( arg == "--verify" ) {
+         verify = true;
+      } else if( arg == "--binary" ) {
+         binary = true;
+      } else if( arg == "--write-binary" && has_value ) {
+         write_binary = argv[++i];
+      } else if( arg.size() > 1 && arg[0] == '-' ) {
+         return usage();
+      } else {
+         path = arg;
+      }
+   }
+   if( path.empty() ) return usage();
+
+   try {
+      // first pass: accounts, and the records themselves when running in parallel
+      std::set<name> accounts;
+      std::vector<log_record> records;
+      std::ofstream out;
+      if( !write_binary.empty() ) {
+         out.open( write_binary, std::ios::binary );
+         if( !out ) throw std::runtime_error( "cannot create " + write_binary );
+      }
+      bool parallel = threads > 1 || verify;
+      read_log( path, binary, [&]( log_record&& r ) {
+         scope_set s;
+         add_accounts( accounts, r, s );
+         if( out.is_open() ) {
+            auto bytes = eosio::pack( r );
+            uint32_t size = bytes.size();
+            out.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+            out.write( bytes.data(), bytes.size() );
+         }
+         if( parallel ) records.push_back( std::move( r ) );
+      });
+      if( out.is_open() ) out.close();
+
+      int status = 0;
+      uint64_t serial_hash = 0;
+      if( !parallel || verify ) {
+         auto result = replay_serial( self, path, binary, accounts );
+         report( "serial", result );
+         serial_hash = result.hash;
+      }
+      if( parallel ) {
+         auto plan = plan_partitions( records, threads );
+         std::printf( "%llu partitions, largest %llu actions (%.1f%%)\n", (unsigned long long)plan.partitions,
+                      (unsigned long long)plan.largest,
+                      records.empty() ? 0.0 : 100.0 * plan.largest / records.size() );
+         auto result = replay_parallel( self, records, plan, accounts );
+         char label[32];
+         std::snprintf( label, sizeof( label ), "parallel x%u", threads );
+         report( label, result );
+         if( verify && serial_hash != result.hash ) {
+            std::fprintf( stderr, "state hash mismatch: serial %016llx, parallel %016llx\n",
+                          (unsigned long long)serial_hash, (unsigned long long)result.hash );
+            status = 1;
+         }
+      }
+      return status;
+   } catch( const std::exception& e ) {
+      std::fprintf( stderr, "rainbow_replay: %s\n", e.what() );
+      return 2;
+   }
+}
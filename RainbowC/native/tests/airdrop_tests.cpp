@@ -0,0 +1,108 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct airdrop_row {
+      uint64_t     id;
+      checksum256  root;
+      asset        remaining;
+      uint64_t     leaves;
+   };
+
+   struct leaf {
+      uint64_t  index;
+      name      owner;
+      int64_t   amount;
+   };
+
+   checksum256 leaf_hash( const leaf& l ) {
+      char buf[32];
+      datastream<char*> ds( buf, sizeof(buf) );
+      ds << l.index << l.owner << asset( l.amount, token_sym );
+      return sha256( buf, sizeof(buf) );
+   }
+
+   checksum256 parent_hash( const checksum256& a, const checksum256& b ) {
+      auto lo = std::min( a, b ).extract_as_byte_array();
+      auto hi = std::max( a, b ).extract_as_byte_array();
+      char buf[64];
+      std::copy( lo.begin(), lo.end(), buf );
+      std::copy( hi.begin(), hi.end(), buf + 32 );
+      return sha256( buf, sizeof(buf) );
+   }
+
+   class airdrop_test : public contract_test {
+   protected:
+      // a two level tree; leaf 3 is a second claim of alice's
+      const std::vector<leaf> leaves{ { 0, alice, 1000 }, { 1, bob, 2000 }, { 2, carol, 3000 }, { 3, alice, 4000 } };
+      std::vector<checksum256> hashes;
+      checksum256 root;
+
+      void SetUp() override {
+         create_token();
+         for( const auto& l : leaves ) {
+            hashes.push_back( leaf_hash( l ) );
+         }
+         root = parent_hash( parent_hash( hashes[0], hashes[1] ), parent_hash( hashes[2], hashes[3] ) );
+         ok( { issuer }, [&]{ tk.setdrop( asset( 10000, token_sym ), root, leaves.size(), "" ); } );
+      }
+
+      /// the sibling leaf, then the parent of the other half of the tree
+      std::vector<checksum256> proof( uint64_t index ) const {
+         auto other = index < 2 ? 2 : 0;
+         return { hashes[index ^ 1], parent_hash( hashes[other], hashes[other + 1] ) };
+      }
+
+      void claim( const leaf& l ) {
+         ok( { l.owner }, [&]{
+            tk.claim( token_sym.code(), 0, l.index, l.owner, asset( l.amount, token_sym ), proof( l.index ) );
+         });
+      }
+
+      int64_t remaining() const {
+         return row<airdrop_row>( token_sym.code().raw(), "airdrops"_n, 0 )->remaining.amount;
+      }
+   };
+
+}
+
+TEST_F( airdrop_test, claims_credit_leaf_amounts_once ) {
+   EXPECT_EQ( remaining(), 10000 );
+   claim( leaves[0] );
+   claim( leaves[1] );
+   claim( leaves[3] );
+   EXPECT_EQ( balance( alice ), 5000 );
+   EXPECT_EQ( balance( bob ), 2000 );
+   EXPECT_EQ( remaining(), 3000 );
+
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.claim( token_sym.code(), 0, 0, alice, asset( 1000, token_sym ), proof( 0 ) );
+   }), "already claimed" );
+   EXPECT_EQ( balance( alice ), 5000 );
+   EXPECT_EQ( remaining(), 3000 );
+}
+
+TEST_F( airdrop_test, claim_must_match_its_leaf ) {
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.claim( token_sym.code(), 0, 0, alice, asset( 1001, token_sym ), proof( 0 ) );
+   }), "invalid proof" );
+   EXPECT_EQ( fails( { carol }, [&]{
+      tk.claim( token_sym.code(), 0, 1, carol, asset( 2000, token_sym ), proof( 1 ) );
+   }), "invalid proof" );
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.claim( token_sym.code(), 0, 4, alice, asset( 1000, token_sym ), proof( 0 ) );
+   }), "leaf index out of range" );
+   EXPECT_EQ( remaining(), 10000 );
+   EXPECT_EQ( balance( alice ), -1 );
+}
+
+TEST_F( airdrop_test, enddrop_returns_unclaimed_tokens_to_issuer ) {
+   claim( leaves[2] );
+   ok( { issuer }, [&]{ tk.enddrop( token_sym.code(), 0, 10 ); } );
+   EXPECT_EQ( balance( issuer ), 7000 );
+   EXPECT_EQ( balance( carol ), 3000 );
+   EXPECT_EQ( rows( token_sym.code().raw(), "airdrops"_n ), 0u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "claimed"_n ), 0u );
+}
@@ -0,0 +1,104 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct allowance_row {
+      uint64_t        id;
+      name            owner;
+      name            spender;
+      asset           remaining;
+      time_point_sec  expiry;
+   };
+
+   class allowance_test : public contract_test {
+   protected:
+      time_point_sec expiry;
+
+      /// RBW with 100 RBW each for alice and bob
+      void SetUp() override {
+         create_token();
+         fund( 2000000, { alice, bob } );
+         expiry = time_point_sec( c.now() + eosio::days( 1 ) );
+      }
+
+      void allow( name owner, name spender, int64_t amount ) {
+         ok( { owner }, [&]{ tk.setallowance( owner, spender, asset( amount, token_sym ), expiry ); } );
+      }
+
+      /// amount left of the first allowance, or -1 without one
+      int64_t remaining() const {
+         auto a = row<allowance_row>( token_sym.code().raw(), "allowances"_n, 0 );
+         return a ? a->remaining.amount : -1;
+      }
+
+      std::string pull_fails( name spender, name from, name to, int64_t amount ) {
+         return fails( { spender }, [&]{ tk.transferfrom( spender, from, to, asset( amount, token_sym ), "" ); } );
+      }
+   };
+
+}
+
+TEST_F( allowance_test, spender_pays_for_rate_limit_row_of_owner ) {
+   ok( { issuer }, [&]{ tk.setlimit( token_sym.code(), 60, 10, asset( 0, token_sym ) ); } );
+   allow( alice, carol, 100000 );
+   auto alice_ram = c.ram_usage( alice );
+   // only carol authorizes, so the ratebuckets row alice does not have yet is carol's to pay for
+   ok( { carol }, [&]{ tk.transferfrom( carol, alice, bob, asset( 10000, token_sym ), "" ); } );
+   EXPECT_EQ( c.ram_usage( alice ), alice_ram );
+   EXPECT_EQ( rows( token_sym.code().raw(), "ratebuckets"_n ), 1u );
+}
+
+TEST_F( allowance_test, pulls_draw_down_allowance_until_used_up ) {
+   allow( alice, carol, 30000 );
+   auto alice_ram = c.ram_usage( alice );
+   ok( { carol }, [&]{ tk.transferfrom( carol, alice, bob, asset( 10000, token_sym ), "" ); } );
+   EXPECT_EQ( remaining(), 20000 );
+   EXPECT_EQ( balance( alice ), 990000 );
+   EXPECT_EQ( balance( bob ), 1010000 );
+   EXPECT_EQ( pull_fails( carol, alice, bob, 20001 ), "overdrawn allowance" );
+   EXPECT_EQ( pull_fails( bob, alice, carol, 1 ), "no allowance for spender" );
+
+   // entries of a batch draw on the same allowance
+   ok( { carol }, [&]{
+      tk.pullmany( carol, { { alice, bob, asset( 5000, token_sym ), "" }, { alice, carol, asset( 15000, token_sym ), "" } } );
+   });
+   EXPECT_EQ( balance( alice ), 970000 );
+   EXPECT_EQ( balance( carol ), 15000 );
+   // a used up allowance is erased, refunding its RAM
+   EXPECT_EQ( remaining(), -1 );
+   EXPECT_LT( c.ram_usage( alice ), alice_ram );
+   EXPECT_EQ( pull_fails( carol, alice, bob, 1 ), "no allowance for spender" );
+}
+
+TEST_F( allowance_test, expired_allowance_cannot_be_drawn ) {
+   allow( alice, carol, 30000 );
+   c.set_time( expiry - 1 );
+   ok( { carol }, [&]{ tk.transferfrom( carol, alice, bob, asset( 10000, token_sym ), "" ); } );
+   c.set_time( expiry );
+   EXPECT_EQ( pull_fails( carol, alice, bob, 10000 ), "allowance has expired" );
+   EXPECT_EQ( remaining(), 20000 );
+   EXPECT_EQ( balance( alice ), 990000 );
+}
+
+TEST_F( allowance_test, reject_clears_allowances_in_batches ) {
+   for( auto owner : { alice, bob } ) {
+      ok( { owner }, [&]{ tk.retire( owner, asset( 1000000, token_sym ), "" ); } );
+   }
+   // one more than a reject erases per call
+   for( uint64_t i = 0; i <= 500; i++ ) {
+      name spender( "spender"_n.value + ( i << 4 ) );
+      c.create_account( spender );
+      allow( alice, spender, 10000 );
+   }
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_NE( last.console.find( "more rows remain" ), std::string::npos ) << last.console;
+   EXPECT_EQ( rows( token_sym.code().raw(), "stat"_n ), 1u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "allowances"_n ), 1u );
+
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "stat"_n ), 0u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "allowances"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "allowances"_n ), 0u );
+}
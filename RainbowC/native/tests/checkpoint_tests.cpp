@@ -0,0 +1,81 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   class checkpoint_test : public contract_test {
+   protected:
+      /// RBW with 100 RBW each for alice and bob and hourly checkpoints
+      void SetUp() override {
+         create_token();
+         fund( 2000000, { alice, bob } );
+         set_checkpoints( 3600 );
+      }
+
+      void set_checkpoints( uint32_t epoch ) {
+         ok( { issuer }, [&]{ tk.setcheckpt( token_sym.code(), epoch, 24 ); } );
+      }
+
+      void send( name from, name to, int64_t amount ) {
+         ok( { from }, [&]{ tk.transfer( from, to, asset( amount, token_sym ), "" ); } );
+      }
+
+      /// balance of `owner` as of `time` by getsnapshot
+      int64_t snapshot( name owner, time_point_sec time ) {
+         std::vector<token::balance_info> result;
+         ok( {}, [&]{ result = tk.getsnapshot( token_sym.code(), time, { owner } ); } );
+         return result.empty() ? -1 : result[0].balance.amount;
+      }
+   };
+
+}
+
+TEST_F( checkpoint_test, snapshot_tells_balance_as_of_past_epoch ) {
+   const time_point_sec first( c.now() );
+   send( alice, bob, 10000 );
+   c.advance( eosio::hours( 2 ) );
+   send( alice, bob, 20000 );
+   EXPECT_EQ( snapshot( alice, first ), 990000 );
+   EXPECT_EQ( snapshot( alice, first + 3600 ), 990000 );
+   EXPECT_EQ( snapshot( alice, time_point_sec( c.now() ) ), 970000 );
+   EXPECT_EQ( snapshot( bob, first + 3600 ), 1010000 );
+   EXPECT_EQ( snapshot( bob, time_point_sec( c.now() ) ), 1030000 );
+   // without a checkpoint the balance has not changed since they were switched on
+   EXPECT_EQ( snapshot( carol, first ), 0 );
+   EXPECT_EQ( snapshot( issuer, first ), 0 );
+}
+
+TEST_F( checkpoint_test, switching_off_clears_rows_of_the_old_setting ) {
+   send( alice, bob, 10000 );
+   ASSERT_GT( rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+   set_checkpoints( 0 );
+   EXPECT_NE( last.console.find( "done" ), std::string::npos ) << last.console;
+   EXPECT_EQ( rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+
+   // a change made while off must not be hidden by a row from before
+   send( alice, bob, 10000 );
+   set_checkpoints( 3600 );
+   EXPECT_EQ( snapshot( alice, time_point_sec( c.now() ) ), 980000 );
+}
+
+TEST_F( checkpoint_test, reject_clears_checkpoints ) {
+   send( alice, bob, 10000 );
+   for( auto owner : { alice, bob } ) {
+      ok( { owner }, [&]{ tk.retire( owner, asset( balance( owner ), token_sym ), "" ); } );
+   }
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_NE( last.console.find( "rejected" ), std::string::npos ) << last.console;
+   for( auto table : { "stat"_n, "ckconfig"_n, "checkpoints"_n } ) {
+      EXPECT_EQ( rows( token_sym.code().raw(), table ), 0u ) << table.to_string();
+   }
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+}
+
+TEST_F( checkpoint_test, history_must_be_bounded ) {
+   set_checkpoints( 0 );
+   EXPECT_EQ( fails( { issuer }, [&]{ tk.setcheckpt( token_sym.code(), 60, 24 ); } ), "epoch is too short" );
+   EXPECT_EQ( fails( { issuer }, [&]{ tk.setcheckpt( token_sym.code(), 3600, 0 ); } ),
+              "retained epochs out of range" );
+}
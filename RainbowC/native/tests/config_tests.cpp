@@ -0,0 +1,108 @@
+#include "contract_test.hpp"
+
+#include <eosio/singleton.hpp>
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct hot_config_row {
+      symbol    supply_symbol;
+      name      issuer;
+      name      withdrawal_mgr;
+      name      withdraw_to;
+      uint32_t  flags;
+   };
+   using hot_configs = eosio::singleton< "hotconfig"_n, hot_config_row >;
+
+   class config_test : public contract_test {};
+
+}
+
+TEST_F( config_test, freeze_of_token_without_hotconfig_row ) {
+   ok( { issuer }, [&]{
+      tk.create( issuer, asset( 1000000, token_sym ), "allowallacct"_n, issuer, issuer, carol, "", "" );
+   });
+   ok( { self }, [&]{ tk.approve( token_sym.code(), false ); } );
+   ok( { issuer }, [&]{ tk.issue( asset( 1000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 1000, token_sym ), "" ); } );
+   // a token created before the hotconfig table
+   ok( { self }, [&]{ hot_configs( self, token_sym.code().raw() ).remove(); } );
+
+   auto issuer_ram = c.ram_usage( issuer );
+   ok( { carol }, [&]{ tk.freeze( token_sym.code(), true, "" ); } );
+   EXPECT_EQ( c.ram_usage( issuer ), issuer_ram );
+   auto hc = row<hot_config_row>( token_sym.code().raw(), "hotconfig"_n, "hotconfig"_n.value );
+   ASSERT_TRUE( hc );
+   EXPECT_EQ( hc->issuer, issuer );
+   EXPECT_EQ( fails( { alice }, [&]{ tk.transfer( alice, bob, asset( 1, token_sym ), "" ); } ),
+              "transfers are frozen" );
+}
+
+TEST_F( config_test, tokenstats_is_opt_in_before_approval ) {
+   create_token();
+   EXPECT_EQ( rows( token_sym.code().raw(), "tokenstats"_n ), 0u );
+   EXPECT_EQ( fails( { issuer }, [&]{ tk.setoption( token_sym.code(), "tokenstats"_n, true ); } ),
+              "tokenstats can only be switched on before approval" );
+   fund( 2000000, { alice, bob } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "tokenstats"_n ), 0u );
+}
+
+TEST_F( config_test, tokenstats_counts_from_creation_until_switched_off ) {
+   create_token( token_sym, { "tokenstats"_n } );
+   fund( 2000000, { alice, bob } );
+   ok( { alice }, [&]{ tk.transfer( alice, carol, asset( 1000000, token_sym ), "" ); } );
+   auto ag = row<aggregates_row>( token_sym.code().raw(), "tokenstats"_n, "tokenstats"_n.value );
+   ASSERT_TRUE( ag );
+   EXPECT_EQ( ag->holders, 2u );   // bob and carol
+   EXPECT_EQ( ag->zero_rows, 2u ); // the issuer and alice
+   EXPECT_EQ( ag->circulating.amount, 2000000 );
+   EXPECT_EQ( ag->transfers, 3u );
+
+   auto issuer_ram = c.ram_usage( issuer );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "tokenstats"_n, false ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "tokenstats"_n ), 0u );
+   EXPECT_LT( c.ram_usage( issuer ), issuer_ram );
+   ok( { bob }, [&]{ tk.transfer( bob, alice, asset( 1, token_sym ), "" ); } );
+}
+
+TEST_F( config_test, reject_clears_rate_limit_and_buckets ) {
+   create_token();
+   fund( 1000000, { alice } );
+   ok( { issuer }, [&]{ tk.setlimit( token_sym.code(), 60, 10, asset( 0, token_sym ) ); } );
+   ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 1000000, token_sym ), "" ); } );
+   ok( { bob }, [&]{ tk.retire( bob, asset( 1000000, token_sym ), "" ); } );
+   const auto scope = token_sym.code().raw();
+   ASSERT_EQ( rows( scope, "ratebuckets"_n ), 1u );
+
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   for( auto table : { "stat"_n, "ratelimit"_n, "ratebuckets"_n } ) {
+      EXPECT_EQ( rows( scope, table ), 0u ) << table.to_string();
+   }
+}
+
+TEST_F( config_test, setrecent_waits_for_config_lock ) {
+   ok( { issuer }, [&]{
+      tk.create( issuer, asset( 1000000, token_sym ), "allowallacct"_n, issuer, issuer, issuer, "", "" );
+   });
+   // the config lock defaults to the creation time
+   EXPECT_EQ( fails( { issuer }, [&]{ tk.setrecent( token_sym.code(), 8 ); }),
+              "token reconfiguration is locked" );
+   c.advance( eosio::seconds( 1 ) );
+   ok( { issuer }, [&]{ tk.setrecent( token_sym.code(), 8 ); } );
+}
+
+TEST_F( config_test, reject_clears_recent_movements ) {
+   create_token();
+   ok( { issuer }, [&]{ tk.setrecent( token_sym.code(), 8 ); } );
+   fund( 1000000, { alice } );
+   ok( { alice }, [&]{ tk.retire( alice, asset( 1000000, token_sym ), "" ); } );
+   const auto scope = token_sym.code().raw();
+   ASSERT_EQ( rows( scope, "recent"_n ), 3u );
+
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   for( auto table : { "stat"_n, "recent"_n, "recenthead"_n } ) {
+      EXPECT_EQ( rows( scope, table ), 0u ) << table.to_string();
+   }
+   EXPECT_EQ( index_rows( scope, "recent"_n ), 0u );
+}
@@ -0,0 +1,147 @@
+/**
+ *  Shared fixture of the native contract tests: a fresh in-memory chain with the rainbow
+ *  contract deployed, the usual accounts created and helpers to run actions and read rows.
+ *  Unlike the benchmarks, tests check what the actions leave behind, not only that they
+ *  succeed.
+ */
+#pragma once
+
+#include <rainbow.hpp>
+#include <chain.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace rainbow_test {
+
+   using namespace eosio;
+
+   inline const name self           = "rainbowtoken"_n;
+   inline const name issuer         = "issuer"_n;
+   inline const name alice          = "alice"_n;
+   inline const name bob            = "bob"_n;
+   inline const name carol          = "carol"_n;
+   inline const name escrow         = "escrow"_n;
+   inline const name stake_contract = "stake.token"_n;
+
+   inline const symbol token_sym( "RBW", 4 );
+   inline const symbol stake_sym( "STK", 4 );
+
+   // layouts of the contract's table rows, which are private to it
+
+   struct account_row {
+      asset  balance;
+   };
+
+   struct escrow_row {
+      uint64_t    stake_index;
+      asset       escrowed;
+      asset       pending;
+      time_point  refreshed;
+   };
+
+   struct aggregates_row {
+      uint64_t  holders;
+      uint64_t  zero_rows;
+      asset     circulating;
+      uint64_t  transfers;
+   };
+
+   /// a stake token transfer sent inline by the contract
+   struct stake_transfer {
+      name   from;
+      name   to;
+      asset  quantity;
+   };
+
+   class contract_test : public ::testing::Test {
+   protected:
+      native::chain c;
+      token         tk{ self, self, datastream<const char*>( nullptr, 0 ) };
+      native::action_result last;
+
+      contract_test() {
+         c.make_current();
+         for( auto n : { self, issuer, alice, bob, carol, escrow, stake_contract } ) {
+            c.create_account( n );
+         }
+      }
+
+      /// runs an action that must succeed
+      template<typename F>
+      void ok( std::vector<name> auths, F&& fn ) {
+         last = c.push( self, std::move( auths ), std::forward<F>( fn ) );
+         EXPECT_TRUE( last.ok ) << last.error;
+      }
+
+      /// runs an action that must fail, returning its error message
+      template<typename F>
+      std::string fails( std::vector<name> auths, F&& fn ) {
+         last = c.push( self, std::move( auths ), std::forward<F>( fn ) );
+         EXPECT_FALSE( last.ok );
+         return last.error;
+      }
+
+      /// creates and approves `sym` with the issuer in every role, unlocked from the next second,
+      /// switching on `options` that must be set before approval
+      void create_token( const symbol& sym = token_sym, const std::vector<name>& options = {} ) {
+         ok( { issuer }, [&]{
+            tk.create( issuer, asset( int64_t(1) << 61, sym ), "allowallacct"_n,
+                       issuer, issuer, issuer, "", "" );
+         });
+         for( auto option : options ) {
+            c.advance( eosio::seconds( 1 ) );
+            ok( { issuer }, [&]{ tk.setoption( sym.code(), option, true ); } );
+         }
+         ok( { self }, [&]{ tk.approve( sym.code(), false ); } );
+         c.advance( eosio::seconds( 1 ) ); // config lock defaults to the creation time
+      }
+
+      /// issues `amount` to the issuer and sends each of `owners` an equal share of it
+      void fund( int64_t amount, const std::vector<name>& owners, const symbol& sym = token_sym ) {
+         ok( { issuer }, [&]{ tk.issue( asset( amount, sym ), "" ); } );
+         for( auto owner : owners ) {
+            ok( { issuer }, [&]{
+               tk.transfer( issuer, owner, asset( amount / int64_t( owners.size() ), sym ), "" );
+            });
+         }
+      }
+
+      /// balance of `owner`, or -1 without an accounts row
+      int64_t balance( name owner, const symbol& sym = token_sym ) const {
+         auto row = c.get_row<account_row>( self, owner.value, "accounts"_n, sym.code().raw() );
+         return row ? row->balance.amount : -1;
+      }
+
+      template<typename T>
+      std::optional<T> row( uint64_t scope, name table, uint64_t pk ) const {
+         return c.get_row<T>( self, scope, table, pk );
+      }
+
+      size_t rows( uint64_t scope, name table ) const { return c.row_count( self, scope, table ); }
+
+      size_t index_rows( uint64_t scope, name table ) const { return c.index_row_count( self, scope, table ); }
+
+      /// sets the balance `owner` holds at the stake token contract
+      void put_stake_balance( name owner, int64_t amount ) {
+         c.put_row( stake_contract, owner.value, "accounts"_n, stake_sym.code().raw(),
+                    account_row{ asset( amount, stake_sym ) }, owner );
+      }
+
+      /// stake token transfers sent by the last action
+      std::vector<stake_transfer> stake_transfers() const {
+         std::vector<stake_transfer> out;
+         for( const auto& a : last.inline_actions ) {
+            if( a.account == stake_contract && a.name == "transfer"_n ) {
+               auto [from, to, quantity, memo] = a.data_as<std::tuple<name, name, asset, std::string>>();
+               out.push_back( { from, to, quantity } );
+            }
+         }
+         return out;
+      }
+   };
+
+}
@@ -0,0 +1,112 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct fee_shard_row {
+      uint64_t  shard;
+      asset     accrued;
+   };
+
+   class fee_test : public contract_test {
+   protected:
+      /// RBW keeping tokenstats with 100 RBW each for alice and bob
+      void SetUp() override {
+         create_token( token_sym, { "tokenstats"_n } );
+         fund( 2000000, { alice, bob } );
+      }
+
+      /// sets a fee swept to carol, opening carol's balance first
+      void set_fee( uint16_t basis_points, int64_t max_fee, uint32_t shards = 4 ) {
+         ok( { issuer }, [&]{ tk.open( carol, token_sym.code(), issuer ); } );
+         ok( { issuer }, [&]{
+            tk.setfee( token_sym.code(), basis_points, asset( max_fee, token_sym ), carol, shards );
+         });
+      }
+
+      void send( name from, name to, int64_t amount, const symbol& sym = token_sym ) {
+         ok( { from }, [&]{ tk.transfer( from, to, asset( amount, sym ), "" ); } );
+      }
+
+      int64_t accrued() const {
+         int64_t total = 0;
+         for( uint64_t shard = 0; shard < 4; shard++ ) {
+            if( auto f = row<fee_shard_row>( token_sym.code().raw(), "feeshards"_n, shard ) ) {
+               total += f->accrued.amount;
+            }
+         }
+         return total;
+      }
+
+      int64_t circulating() const {
+         return c.get_row<aggregates_row>( self, token_sym.code().raw(), "tokenstats"_n, "tokenstats"_n.value )
+                   ->circulating.amount;
+      }
+   };
+
+}
+
+TEST_F( fee_test, sender_pays_fee_on_top_and_treasury_gets_it_when_swept ) {
+   set_fee( 25, 0 );
+   send( alice, bob, 100000 );
+   send( bob, alice, 40000 );
+   EXPECT_EQ( balance( alice ), 1000000 - 100000 - 250 + 40000 );
+   EXPECT_EQ( balance( bob ), 1000000 + 100000 - 40000 - 100 );
+   EXPECT_EQ( accrued(), 350 );
+   EXPECT_EQ( balance( carol ), 0 );
+
+   ok( {}, [&]{ tk.sweepfees( token_sym.code(), 4 ); } );
+   EXPECT_EQ( balance( carol ), 350 );
+   EXPECT_EQ( rows( token_sym.code().raw(), "feeshards"_n ), 0u );
+   EXPECT_EQ( fails( {}, [&]{ tk.sweepfees( token_sym.code(), 4 ); } ), "no fees to sweep" );
+}
+
+TEST_F( fee_test, fee_is_capped_and_spares_issuer_and_treasury ) {
+   set_fee( 500, 1000 );
+   send( alice, bob, 100000 );
+   EXPECT_EQ( balance( alice ), 1000000 - 100000 - 1000 );
+   send( alice, carol, 100000 );
+   send( carol, bob, 100000 );
+   EXPECT_EQ( balance( carol ), 0 );
+   ok( { issuer }, [&]{ tk.issue( asset( 100000, token_sym ), "" ); } );
+   send( issuer, bob, 100000 );
+   EXPECT_EQ( balance( issuer ), 0 );
+   EXPECT_EQ( accrued(), 2000 );
+}
+
+TEST_F( fee_test, fee_cap_follows_precision_migration ) {
+   set_fee( 500, 10000 ); // 5%, at most 1 RBW
+   const symbol rbw6( "RBW", 6 );
+   ok( { issuer }, [&]{
+      tk.create( issuer, asset( int64_t(1) << 61, rbw6 ), "allowallacct"_n, issuer, issuer, issuer, "", "" );
+   });
+   ok( {}, [&]{ tk.migrate( token_sym.code(), { issuer, alice, bob, carol } ); } );
+   EXPECT_EQ( balance( alice, rbw6 ), 100000000 );
+   send( alice, bob, 50000000, rbw6 );
+   EXPECT_EQ( balance( alice, rbw6 ), 100000000 - 50000000 - 1000000 );
+}
+
+TEST_F( fee_test, circulating_reset_leaves_out_unswept_fees ) {
+   set_fee( 100, 0 );
+   send( alice, bob, 10000 );
+   EXPECT_EQ( circulating(), 2000000 - 100 );
+   // a new withdraw_to recounts circulating from the supply
+   ok( { issuer }, [&]{
+      tk.create( issuer, asset( int64_t(1) << 61, token_sym ), "allowallacct"_n, issuer, carol, issuer, "", "" );
+   });
+   EXPECT_EQ( circulating(), 2000000 - 100 );
+}
+
+TEST_F( fee_test, reject_clears_fee_settings ) {
+   set_fee( 25, 0 );
+   send( alice, bob, 100000 );
+   ok( {}, [&]{ tk.sweepfees( token_sym.code(), 4 ); } );
+   for( auto owner : { alice, bob, carol } ) {
+      ok( { owner }, [&]{ tk.retire( owner, asset( balance( owner ), token_sym ), "" ); } );
+   }
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   for( auto table : { "stat"_n, "feeconfig"_n, "feeshards"_n } ) {
+      EXPECT_EQ( rows( token_sym.code().raw(), table ), 0u ) << table.to_string();
+   }
+}
@@ -0,0 +1,54 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   class holder_test : public contract_test {
+   protected:
+      /// RBW keeping holders with 100 RBW each for alice and bob
+      void SetUp() override {
+         create_token( token_sym, { "holders"_n } );
+         fund( 2000000, { alice, bob } );
+      }
+
+      size_t holder_rows() const { return rows( token_sym.code().raw(), "holders"_n ); }
+   };
+
+}
+
+TEST_F( holder_test, rows_are_paid_by_the_payer_of_the_balance ) {
+   EXPECT_EQ( holder_rows(), 3u );
+   auto self_ram = c.ram_usage( self );
+   auto alice_ram = c.ram_usage( alice );
+   ok( { alice }, [&]{ tk.transfer( alice, carol, asset( 10000, token_sym ), "" ); } );
+   ok( { alice }, [&]{ tk.open( escrow, token_sym.code(), alice ); } );
+   EXPECT_EQ( holder_rows(), 5u );
+   EXPECT_EQ( c.ram_usage( self ), self_ram );
+   EXPECT_GT( c.ram_usage( alice ), alice_ram );
+}
+
+TEST_F( holder_test, balances_from_before_the_option_are_indexed_by_the_issuer ) {
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "holders"_n, false ); } );
+   ok( { alice }, [&]{ tk.transfer( alice, carol, asset( 10000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "holders"_n, true ); } );
+   // carol's balance is not added by a change made without her authority
+   ok( { alice }, [&]{ tk.transfer( alice, carol, asset( 10000, token_sym ), "" ); } );
+   EXPECT_EQ( holder_rows(), 3u );
+
+   fails( { alice }, [&]{ tk.indexholders( token_sym.code(), { carol } ); } );
+   auto self_ram = c.ram_usage( self );
+   ok( { issuer }, [&]{ tk.indexholders( token_sym.code(), { carol } ); } );
+   EXPECT_EQ( holder_rows(), 4u );
+   EXPECT_EQ( c.ram_usage( self ), self_ram );
+}
+
+TEST_F( holder_test, reject_clears_holders ) {
+   for( auto owner : { alice, bob } ) {
+      ok( { owner }, [&]{ tk.retire( owner, asset( 1000000, token_sym ), "" ); } );
+   }
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "stat"_n ), 0u );
+   EXPECT_EQ( holder_rows(), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "holders"_n ), 0u );
+}
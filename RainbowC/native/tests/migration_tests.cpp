@@ -0,0 +1,120 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct stats_row {
+      asset  supply;
+      asset  max_supply;
+      name   issuer;
+   };
+
+   struct migration_row {
+      asset     max_supply;
+      asset     migrated;
+      asset     rescaled;
+      uint64_t  rows;
+      name      next;
+   };
+
+   class migration_test : public contract_test {
+   protected:
+      const symbol rbw2{ "RBW", 2 };
+
+      /// RBW,4 with balances that lose their last two digits at two decimals
+      void SetUp() override {
+         create_token();
+         ok( { issuer }, [&]{ tk.issue( asset( 2000000, token_sym ), "" ); } );
+         ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 1000055, token_sym ), "" ); } );
+         ok( { issuer }, [&]{ tk.transfer( issuer, bob, asset( 999899, token_sym ), "" ); } );
+      }
+
+      void start() {
+         ok( { issuer }, [&]{
+            tk.create( issuer, asset( 10000000, rbw2 ), "allowallacct"_n, issuer, issuer, issuer, "", "" );
+         });
+      }
+
+      void migrate( std::vector<name> owners ) {
+         ok( {}, [&]{ tk.migrate( token_sym.code(), owners ); } );
+      }
+
+      stats_row stat() const { return *row<stats_row>( token_sym.code().raw(), "stat"_n, token_sym.code().raw() ); }
+
+      std::optional<migration_row> progress() const {
+         return row<migration_row>( token_sym.code().raw(), "migration"_n, "migration"_n.value );
+      }
+   };
+
+}
+
+TEST_F( migration_test, batches_add_up_to_supply_and_burn_truncation ) {
+   start();
+   EXPECT_EQ( fails( { alice }, [&]{ tk.transfer( alice, bob, asset( 1, token_sym ), "" ); } ),
+              "token is migrating" );
+
+   migrate( { alice } );
+   auto mg = progress();
+   ASSERT_TRUE( mg );
+   EXPECT_EQ( mg->migrated, asset( 1000055, token_sym ) );
+   EXPECT_EQ( mg->rescaled, asset( 10000, rbw2 ) );
+   EXPECT_EQ( mg->rows, 1u );
+   EXPECT_EQ( stat().supply, asset( 2000000, token_sym ) );
+
+   // alice is already rescaled and not counted twice
+   migrate( { alice, bob, issuer } );
+   EXPECT_FALSE( progress() );
+   EXPECT_EQ( balance( alice, rbw2 ), 10000 );
+   EXPECT_EQ( balance( bob, rbw2 ), 9998 );
+   EXPECT_EQ( balance( issuer, rbw2 ), 0 );
+   EXPECT_EQ( stat().supply, asset( 19998, rbw2 ) );
+   EXPECT_EQ( stat().max_supply, asset( 10000000, rbw2 ) );
+
+   ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 1, rbw2 ), "" ); } );
+   EXPECT_EQ( balance( bob, rbw2 ), 9999 );
+}
+
+TEST_F( migration_test, walks_the_holders_table_in_batches ) {
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "holders"_n, true ); } );
+   ok( { issuer }, [&]{ tk.indexholders( token_sym.code(), { issuer, alice, bob } ); } );
+   ok( { issuer }, [&]{ tk.issue( asset( 10000, token_sym ), "" ); } );
+   // one more batch of holders than a migrate takes
+   for( uint64_t i = 0; i < 100; i++ ) {
+      name holder( "holder"_n.value + ( i << 4 ) );
+      c.create_account( holder );
+      ok( { issuer }, [&]{ tk.transfer( issuer, holder, asset( 100, token_sym ), "" ); } );
+   }
+   start();
+   migrate( {} );
+   auto mg = progress();
+   ASSERT_TRUE( mg );
+   EXPECT_EQ( mg->rows, 100u );
+   EXPECT_NE( mg->next, name() );
+
+   migrate( {} );
+   EXPECT_FALSE( progress() );
+   EXPECT_EQ( balance( alice, rbw2 ), 10000 );
+   EXPECT_EQ( balance( "holder"_n, rbw2 ), 1 );
+}
+
+TEST_F( migration_test, owners_are_required_without_holders_table ) {
+   start();
+   EXPECT_EQ( fails( {}, [&]{ tk.migrate( token_sym.code(), {} ); }),
+              "owners are required unless the holders option is on" );
+}
+
+TEST_F( migration_test, issuer_can_end_it_before_every_balance_is_reached ) {
+   start();
+   migrate( { alice } );
+   fails( { alice }, [&]{ tk.endmigrate( token_sym.code() ); } );
+   ok( { issuer }, [&]{ tk.endmigrate( token_sym.code() ); } );
+   EXPECT_FALSE( progress() );
+   // alice's 100.0055 became 100.00 and the rest of the supply is rescaled as a whole
+   EXPECT_EQ( stat().supply, asset( 19999, rbw2 ) );
+
+   // bob's balance is rescaled when it changes
+   ok( { bob }, [&]{ tk.transfer( bob, alice, asset( 1, rbw2 ), "" ); } );
+   EXPECT_EQ( balance( bob, rbw2 ), 9997 );
+   EXPECT_EQ( balance( alice, rbw2 ), 10001 );
+}
@@ -0,0 +1,102 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct cleanup_row {
+      uint64_t  scope;
+      uint64_t  erased;
+      uint64_t  next;
+   };
+
+   class resetram_test : public contract_test {
+   protected:
+      /// RBW with 100 RBW each for alice and bob
+      void SetUp() override {
+         create_token();
+         fund( 2000000, { alice, bob } );
+      }
+
+      void resetram( name table, const std::string& scope = "RBW" ) {
+         ok( { self }, [&]{ tk.resetram( table, scope, 100 ); } );
+         EXPECT_NE( last.console.find( "done" ), std::string::npos ) << last.console;
+      }
+   };
+
+}
+
+// each table's secondary index rows are erased with it, returning all the RAM its payer paid
+
+TEST_F( resetram_test, schedules_and_their_due_index ) {
+   auto alice_ram = c.ram_usage( alice );
+   for( int i = 0; i < 3; i++ ) {
+      ok( { alice }, [&]{
+         tk.schedule( alice, bob, asset( 10000 + i, token_sym ), 86400, time_point_sec( c.now() + eosio::days( 1 ) ), "" );
+      });
+   }
+   resetram( "schedules"_n );
+   EXPECT_EQ( rows( token_sym.code().raw(), "schedules"_n ), 0u );
+   EXPECT_EQ( c.ram_usage( alice ), alice_ram );
+}
+
+TEST_F( resetram_test, checkpoints_and_their_owner_epoch_index ) {
+   ok( { issuer }, [&]{ tk.setcheckpt( token_sym.code(), 3600, 24 ); } );
+   ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 10000, token_sym ), "" ); } );
+   ASSERT_GT( rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+   resetram( "checkpoints"_n );
+   EXPECT_EQ( rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "checkpoints"_n ), 0u );
+}
+
+TEST_F( resetram_test, recent_and_its_sequence_index ) {
+   ok( { issuer }, [&]{ tk.setrecent( token_sym.code(), 8 ); } );
+   for( int i = 0; i < 3; i++ ) {
+      ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 10000, token_sym ), "" ); } );
+   }
+   ASSERT_EQ( rows( token_sym.code().raw(), "recent"_n ), 3u );
+   resetram( "recent"_n );
+   EXPECT_EQ( rows( token_sym.code().raw(), "recent"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "recent"_n ), 0u );
+}
+
+TEST_F( resetram_test, allowances_and_their_owner_spender_index ) {
+   auto expiry = time_point_sec( c.now() + eosio::days( 1 ) );
+   for( auto spender : { bob, carol } ) {
+      ok( { alice }, [&]{ tk.setallowance( alice, spender, asset( 10000, token_sym ), expiry ); } );
+   }
+   ASSERT_EQ( rows( token_sym.code().raw(), "allowances"_n ), 2u );
+   resetram( "allowances"_n );
+   EXPECT_EQ( rows( token_sym.code().raw(), "allowances"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "allowances"_n ), 0u );
+}
+
+TEST_F( resetram_test, resumes_where_the_last_call_stopped ) {
+   ok( { issuer }, [&]{ tk.setrecent( token_sym.code(), 8 ); } );
+   for( int i = 0; i < 3; i++ ) {
+      ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 10000, token_sym ), "" ); } );
+   }
+   // empty entries of the scope list are skipped
+   ok( { self }, [&]{ tk.resetram( "recent"_n, ",RBW,", 1 ); } );
+   auto cursor = row<cleanup_row>( "recent"_n.value, "cleanups"_n, token_sym.code().raw() );
+   ASSERT_TRUE( cursor );
+   EXPECT_EQ( cursor->erased, 1u );
+   EXPECT_EQ( cursor->next, 1u );
+   resetram( "recent"_n, "RBW," );
+   EXPECT_EQ( rows( token_sym.code().raw(), "recent"_n ), 0u );
+   EXPECT_EQ( rows( "recent"_n.value, "cleanups"_n ), 0u );
+}
+
+TEST_F( resetram_test, blobs_are_released_with_displayrefs ) {
+   const std::string logo( 100, 'l' );
+   ok( { issuer }, [&]{ tk.setdisplay( issuer, token_sym.code(), "rainbow", logo, "", "", "", "" ); } );
+   ASSERT_EQ( rows( self.value, "blobs"_n ), 1u );
+   // the displayrefs row still refers to the blob
+   resetram( "blobs"_n, self.to_string() );
+   EXPECT_EQ( rows( self.value, "blobs"_n ), 1u );
+
+   resetram( "displayrefs"_n );
+   EXPECT_EQ( rows( token_sym.code().raw(), "displayrefs"_n ), 0u );
+   EXPECT_EQ( rows( self.value, "blobs"_n ), 0u );
+   EXPECT_EQ( index_rows( self.value, "blobs"_n ), 0u );
+}
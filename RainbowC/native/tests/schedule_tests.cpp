@@ -0,0 +1,117 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   struct schedule_row {
+      uint64_t        id;
+      name            payer;
+      name            payee;
+      asset           quantity;
+      uint32_t        period;
+      time_point_sec  next_due;
+      std::string     memo;
+   };
+
+   class schedule_test : public contract_test {
+   protected:
+      /// RBW with 100 RBW each for alice and bob
+      void SetUp() override {
+         create_token();
+         fund( 2000000, { alice, bob } );
+      }
+
+      /// schedules a daily payment of `amount` from alice to bob, first due now
+      void schedule_daily( int64_t amount ) {
+         ok( { alice }, [&]{
+            tk.schedule( alice, bob, asset( amount, token_sym ), 86400, time_point_sec( c.now() ), "" );
+         });
+      }
+
+      void crank() { ok( {}, [&]{ tk.crank( token_sym.code(), 10 ); } ); }
+   };
+
+}
+
+TEST_F( schedule_test, crank_misses_payment_over_rate_limit ) {
+   ok( { issuer }, [&]{ tk.setlimit( token_sym.code(), 60, 1, asset( 0, token_sym ) ); } );
+   schedule_daily( 10000 );
+   ok( { alice }, [&]{ tk.transfer( alice, bob, asset( 10000, token_sym ), "" ); } );
+   crank();
+   EXPECT_NE( last.console.find( "paid 0, missed 1" ), std::string::npos ) << last.console;
+   EXPECT_EQ( balance( alice ), 990000 );
+   EXPECT_EQ( balance( bob ), 1010000 );
+   auto sc = row<schedule_row>( token_sym.code().raw(), "schedules"_n, 0 );
+   ASSERT_TRUE( sc );
+   EXPECT_EQ( sc->next_due, time_point_sec( c.now() + eosio::days( 1 ) ) );
+
+   // a day later the allowance has refilled and the payment goes through
+   c.advance( eosio::days( 1 ) );
+   crank();
+   EXPECT_NE( last.console.find( "paid 1, missed 0" ), std::string::npos ) << last.console;
+   EXPECT_EQ( balance( alice ), 980000 );
+   EXPECT_EQ( balance( bob ), 1020000 );
+}
+
+TEST_F( schedule_test, crank_charges_transfer_fee ) {
+   ok( { issuer }, [&]{ tk.setfee( token_sym.code(), 100, asset( 0, token_sym ), issuer, 1 ); } );
+   schedule_daily( 10000 );
+   crank();
+   EXPECT_EQ( balance( alice ), 989900 );
+   EXPECT_EQ( balance( bob ), 1010000 );
+   ok( {}, [&]{ tk.sweepfees( token_sym.code(), 1 ); } );
+   EXPECT_EQ( balance( issuer ), 100 );
+}
+
+TEST_F( schedule_test, crank_misses_payment_without_funds_for_fee ) {
+   ok( { issuer }, [&]{ tk.setfee( token_sym.code(), 100, asset( 0, token_sym ), issuer, 1 ); } );
+   schedule_daily( 1000000 );
+   crank();
+   EXPECT_NE( last.console.find( "paid 0, missed 1" ), std::string::npos ) << last.console;
+   EXPECT_EQ( balance( alice ), 1000000 );
+   // a missed payment accrues no fee
+   EXPECT_EQ( rows( token_sym.code().raw(), "feeshards"_n ), 0u );
+}
+
+TEST_F( schedule_test, schedule_waits_for_migration ) {
+   ok( { issuer }, [&]{
+      tk.create( issuer, asset( int64_t(1) << 61, symbol( "RBW", 6 ) ), "allowallacct"_n,
+                 issuer, issuer, issuer, "", "" );
+   });
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.schedule( alice, bob, asset( 10000, token_sym ), 86400, time_point_sec( c.now() ), "" );
+   }), "token is migrating" );
+}
+
+TEST_F( schedule_test, reject_clears_schedules ) {
+   ok( { alice }, [&]{
+      tk.schedule( alice, bob, asset( 10000, token_sym ), 86400, time_point_sec( c.now() + eosio::days( 1 ) ), "" );
+   });
+   for( auto owner : { alice, bob } ) {
+      ok( { owner }, [&]{ tk.retire( owner, asset( 1000000, token_sym ), "" ); } );
+   }
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "stat"_n ), 0u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "schedules"_n ), 0u );
+   EXPECT_EQ( index_rows( token_sym.code().raw(), "schedules"_n ), 0u );
+}
+
+TEST_F( schedule_test, crank_waits_for_freeze_to_lift ) {
+   schedule_daily( 10000 );
+   ok( { issuer }, [&]{ tk.freeze( token_sym.code(), true, "" ); } );
+   EXPECT_EQ( fails( {}, [&]{ tk.crank( token_sym.code(), 10 ); } ), "transfers are frozen" );
+   ok( { issuer }, [&]{ tk.freeze( token_sym.code(), false, "" ); } );
+   crank();
+   EXPECT_NE( last.console.find( "paid 1, missed 0" ), std::string::npos ) << last.console;
+   EXPECT_EQ( balance( bob ), 1010000 );
+}
+
+TEST_F( schedule_test, schedule_must_start_now_or_later_with_long_enough_period ) {
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.schedule( alice, bob, asset( 10000, token_sym ), 86400, time_point_sec( c.now() - eosio::days( 1 ) ), "" );
+   }), "first payment must not be due in the past" );
+   EXPECT_EQ( fails( { alice }, [&]{
+      tk.schedule( alice, bob, asset( 10000, token_sym ), 1, time_point_sec( c.now() ), "" );
+   }), "period is too short" );
+}
@@ -0,0 +1,166 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   class staking_test : public contract_test {
+   protected:
+      /// RBW with one proportional stake of 1 STK per RBW held by `escrow`, 100 RBW issued
+      void setup_proportional() {
+         put_stake_balance( issuer, 0 );
+         create_token();
+         ok( { issuer }, [&]{
+            tk.setstake( issuer, asset( 10000, token_sym ), asset( 10000, stake_sym ),
+                         stake_contract, escrow, false, true, "" );
+         });
+         ok( { issuer }, [&]{ tk.issue( asset( 1000000, token_sym ), "" ); } );
+         // inline transfers are not executed, so the escrow's holdings are set directly
+         put_stake_balance( escrow, 1000000 );
+      }
+
+      int64_t escrowed() const {
+         return row<escrow_row>( token_sym.code().raw(), "escrows"_n, 0 )->escrowed.amount;
+      }
+
+      int64_t pending() const {
+         return row<escrow_row>( token_sym.code().raw(), "escrows"_n, 0 )->pending.amount;
+      }
+   };
+
+}
+
+TEST_F( staking_test, proportional_retire_redeems_share_of_escrow ) {
+   setup_proportional();
+   EXPECT_EQ( escrowed(), 1000000 );
+   // the escrow lost a fifth of its stake; the next refresh picks that up
+   put_stake_balance( escrow, 800000 );
+   c.advance( eosio::days( 2 ) );
+   ok( { issuer }, [&]{ tk.retire( issuer, asset( 250000, token_sym ), "" ); } );
+   auto paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 1u );
+   EXPECT_EQ( paid[0].from, escrow );
+   EXPECT_EQ( paid[0].to, issuer );
+   EXPECT_EQ( paid[0].quantity, asset( 200000, stake_sym ) );
+   EXPECT_EQ( escrowed(), 600000 );
+}
+
+TEST_F( staking_test, settlement_redemptions_never_exceed_escrow ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.transfer( issuer, bob, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { alice }, [&]{ tk.retire( alice, asset( 500000, token_sym ), "" ); } );
+   ok( { bob }, [&]{ tk.retire( bob, asset( 500000, token_sym ), "" ); } );
+   EXPECT_EQ( escrowed(), 1000000 );
+   EXPECT_EQ( pending(), -1000000 );
+
+   ok( {}, [&]{ tk.settle( token_sym.code(), 0, 50 ); } );
+   int64_t total = 0;
+   for( const auto& t : stake_transfers() ) {
+      EXPECT_EQ( t.from, escrow );
+      total += t.quantity.amount;
+   }
+   EXPECT_EQ( total, 1000000 );
+   EXPECT_EQ( escrowed(), 0 );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 0u );
+}
+
+TEST_F( staking_test, settlement_pays_each_owner_separately ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { alice }, [&]{ tk.retire( alice, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.issue( asset( 500000, token_sym ), "" ); } );
+   // the issuer's new stake is owed to the escrow and offsets alice's redemption
+   EXPECT_EQ( escrowed(), 1000000 );
+   EXPECT_EQ( pending(), 0 );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 2u );
+
+   ok( {}, [&]{ tk.settle( token_sym.code(), 0, 50 ); } );
+   auto paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 2u );
+   EXPECT_EQ( paid[0].to, alice );
+   EXPECT_EQ( paid[0].quantity, asset( 500000, stake_sym ) );
+   EXPECT_EQ( paid[1].from, issuer );
+   EXPECT_EQ( paid[1].quantity, asset( 500000, stake_sym ) );
+   EXPECT_EQ( escrowed(), 1000000 );
+}
+
+TEST_F( staking_test, redemption_shares_stake_waiting_for_settle ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 1000000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { issuer }, [&]{ tk.issue( asset( 1000000, token_sym ), "" ); } );
+   EXPECT_EQ( escrowed(), 1000000 );
+   EXPECT_EQ( pending(), 1000000 );
+   // half the supply redeems half of the escrow including the unsettled stake
+   ok( { alice }, [&]{ tk.retire( alice, asset( 1000000, token_sym ), "" ); } );
+   EXPECT_EQ( pending(), 0 );
+
+   ok( {}, [&]{ tk.settle( token_sym.code(), 0, 50 ); } );
+   auto paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 2u );
+   EXPECT_EQ( paid[0].to, alice );
+   EXPECT_EQ( paid[0].quantity, asset( 1000000, stake_sym ) );
+   EXPECT_EQ( paid[1].from, issuer );
+   EXPECT_EQ( paid[1].quantity, asset( 1000000, stake_sym ) );
+   EXPECT_EQ( escrowed(), 1000000 );
+   EXPECT_EQ( pending(), 0 );
+}
+
+TEST_F( staking_test, settlement_nets_stakes_and_redemptions_of_an_owner ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { issuer }, [&]{ tk.issue( asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.retire( issuer, asset( 200000, token_sym ), "" ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 1u );
+   EXPECT_EQ( pending(), 300000 );
+
+   ok( {}, [&]{ tk.settle( token_sym.code(), 0, 50 ); } );
+   auto paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 1u );
+   EXPECT_EQ( paid[0].from, issuer );
+   EXPECT_EQ( paid[0].to, escrow );
+   EXPECT_EQ( paid[0].quantity, asset( 300000, stake_sym ) );
+   EXPECT_EQ( escrowed(), 1300000 );
+   EXPECT_EQ( pending(), 0 );
+}
+
+TEST_F( staking_test, settle_can_skip_a_row ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.transfer( issuer, bob, asset( 500000, token_sym ), "" ); } );
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { alice }, [&]{ tk.retire( alice, asset( 500000, token_sym ), "" ); } );
+   ok( { bob }, [&]{ tk.retire( bob, asset( 500000, token_sym ), "" ); } );
+
+   // alice's row is left for later, bob is paid
+   ok( {}, [&]{ tk.settle( token_sym.code(), 1, 50 ); } );
+   auto paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 1u );
+   EXPECT_EQ( paid[0].to, bob );
+   EXPECT_EQ( escrowed(), 500000 );
+   EXPECT_EQ( pending(), -500000 );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 1u );
+   EXPECT_EQ( fails( {}, [&]{ tk.settle( token_sym.code(), 1, 50 ); }), "nothing to settle" );
+
+   ok( {}, [&]{ tk.settle( token_sym.code(), 0, 50 ); } );
+   paid = stake_transfers();
+   ASSERT_EQ( paid.size(), 1u );
+   EXPECT_EQ( paid[0].to, alice );
+   EXPECT_EQ( escrowed(), 0 );
+   EXPECT_EQ( pending(), 0 );
+}
+
+TEST_F( staking_test, reject_clears_settlements ) {
+   setup_proportional();
+   ok( { issuer }, [&]{ tk.setoption( token_sym.code(), "settlement"_n, true ); } );
+   ok( { issuer }, [&]{ tk.retire( issuer, asset( 1000000, token_sym ), "" ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 1u );
+
+   ok( { self }, [&]{ tk.approve( token_sym.code(), true ); } );
+   EXPECT_EQ( rows( token_sym.code().raw(), "settlements"_n ), 0u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "escrows"_n ), 0u );
+   EXPECT_EQ( rows( token_sym.code().raw(), "stakes"_n ), 0u );
+}
@@ -0,0 +1,75 @@
+#include "contract_test.hpp"
+
+using namespace rainbow_test;
+
+namespace {
+
+   class vesting_test : public contract_test {
+   protected:
+      time_point_sec start;
+
+      /// RBW with 100 RBW held by the issuer
+      void SetUp() override {
+         create_token();
+         ok( { issuer }, [&]{ tk.issue( asset( 1000000, token_sym ), "" ); } );
+         start = time_point_sec( c.now() );
+      }
+
+      /// grants alice `amount` vesting over 1000 seconds from `start`, with a 100 second cliff
+      void grant( int64_t amount ) {
+         ok( { issuer }, [&]{ tk.vest( alice, asset( amount, token_sym ), start, 100, 1000, "" ); } );
+      }
+
+      /// advances the chain to `seconds` after `start`
+      void at( uint32_t seconds ) { c.set_time( start + seconds ); }
+
+      void spend( int64_t amount ) {
+         ok( { alice }, [&]{ tk.transfer( alice, bob, asset( amount, token_sym ), "" ); } );
+      }
+
+      std::string spend_fails( int64_t amount ) {
+         return fails( { alice }, [&]{ tk.transfer( alice, bob, asset( amount, token_sym ), "" ); } );
+      }
+   };
+
+}
+
+TEST_F( vesting_test, grant_vests_linearly_after_cliff ) {
+   grant( 100000 );
+   EXPECT_EQ( balance( alice ), 100000 );
+   at( 99 );
+   EXPECT_EQ( spend_fails( 1 ), "balance is locked until vested" );
+   // from the cliff the grant vests as if from the start: 250 of 1000 seconds, a quarter
+   at( 250 );
+   spend( 25000 );
+   EXPECT_EQ( spend_fails( 1 ), "balance is locked until vested" );
+   at( 600 );
+   spend( 35000 );
+   EXPECT_EQ( spend_fails( 1 ), "balance is locked until vested" );
+   at( 1000 );
+   spend( 40000 );
+   EXPECT_EQ( balance( alice ), 0 );
+}
+
+TEST_F( vesting_test, lock_leaves_unvested_part_of_balance_spendable ) {
+   ok( { issuer }, [&]{ tk.transfer( issuer, alice, asset( 50000, token_sym ), "" ); } );
+   grant( 100000 );
+   at( 50 );
+   spend( 50000 );
+   EXPECT_EQ( spend_fails( 1 ), "balance is locked until vested" );
+   EXPECT_EQ( balance( alice ), 100000 );
+}
+
+TEST_F( vesting_test, grant_is_replaced_only_once_vested ) {
+   grant( 100000 );
+   at( 500 );
+   EXPECT_EQ( fails( { issuer }, [&]{
+      tk.vest( alice, asset( 1000, token_sym ), start, 0, 10, "" );
+   }), "owner already has a vesting grant" );
+   at( 1000 );
+   start = time_point_sec( c.now() );
+   grant( 20000 );
+   EXPECT_EQ( balance( alice ), 120000 );
+   spend( 100000 );
+   EXPECT_EQ( spend_fails( 1 ), "balance is locked until vested" );
+}
@@ -1,8 +1,41 @@
 #include <rainbow.hpp>
 #include <../capi/eosio/action.h>
 
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+
+// Build with -DRAINBOW_TRACE for a console trace of stake transfers; off in release builds.
+#ifdef RAINBOW_TRACE
+#define RAINBOW_TRACE_PRINT(...) eosio::print( __VA_ARGS__ )
+#else
+#define RAINBOW_TRACE_PRINT(...)
+#endif
+
 namespace eosio {
 
+// erases rows from the start of `table` while `limit` lasts, counting it down; true once the table is empty
+template<typename Table>
+bool token::erase_rows( Table&& table, uint32_t& limit ) {
+    auto itr = table.begin();
+    for( ; itr != table.end() && limit > 0; limit-- ) {
+       itr = table.erase(itr);
+    }
+    return itr == table.end();
+}
+
+// as above from primary key `next` on, leaving `next` at the first row kept; true once the end is reached
+template<typename Table>
+bool token::erase_rows( Table&& table, uint64_t& next, uint32_t& limit ) {
+    auto itr = table.lower_bound( next );
+    for( ; itr != table.end() && limit > 0; limit-- ) {
+       itr = table.erase(itr);
+    }
+    next = itr != table.end() ? itr->primary_key() : 0;
+    return itr == table.end();
+}
+
 void token::create( const name&   issuer,
                     const asset&  maximum_supply,
                     const name&   membership_mgr,
@@ -19,7 +52,16 @@ void token::create( const name&   issuer,
     check( maximum_supply.amount > 0, "max-supply must be positive");
     check( is_account( membership_mgr ) || membership_mgr == allowallacct,
         "membership_mgr account does not exist");
+    if constexpr( !with_membership ) {
+       check( membership_mgr == allowallacct, "membership_mgr must be allowallacct in this build" );
+    }
     check( is_account( withdrawal_mgr ), "withdrawal_mgr account does not exist");
+    if constexpr( !with_withdrawal ) {
+       // the role has no power in this build, but the configs row outlives it: were the contract
+       // later redeployed as a build with withdrawals, any other account named here would gain
+       // the power to withdraw from every holder without the issuer ever having granted it
+       check( withdrawal_mgr == issuer, "withdrawal_mgr must be the issuer in this build" );
+    }
     check( is_account( withdraw_to ), "withdraw_to account does not exist");
     check( is_account( freeze_mgr ), "freeze_mgr account does not exist");
     time_point redeem_locked_until = current_time_point();
@@ -46,18 +88,36 @@ void token::create( const name&   issuer,
        check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
               "token reconfiguration is locked" );
        check( st.issuer == issuer, "mismatched issuer account" );
+       migrations migtable( get_self(), sym.code().raw() );
+       check( !migtable.exists(), "token is migrating" );
+       bool migrating = st.supply.amount != 0 && sym != st.supply.symbol;
        if( st.supply.amount != 0 ) {
-          check( sym == st.supply.symbol,
-                 "cannot change symbol precision with outstanding supply" );
-          //TBD: could support precision change by walking accounts table
-          check( maximum_supply.amount >= st.supply.amount,
+          check( maximum_supply.amount >= rescale( st.supply, sym ).amount,
                  "cannot reduce maximum below outstanding supply" );
        }
-       statstable.modify (st, issuer, [&]( auto& s ) {
-          s.supply.symbol = maximum_supply.symbol;
-          s.max_supply    = maximum_supply;
-          s.issuer        = issuer;
-       });
+       if( migrating ) {
+          airdrops droptable( get_self(), sym.code().raw() );
+          check( droptable.begin() == droptable.end(), "cannot change precision during an airdrop" );
+          feeshards shardtable( get_self(), sym.code().raw() );
+          check( shardtable.begin() == shardtable.end(), "cannot change precision with unswept fees" );
+          // balances are rescaled by migrate; stat keeps the old precision until then
+          stakes stakestable( get_self(), sym.code().raw() );
+          for( auto itr = stakestable.begin(); itr != stakestable.end(); itr++ ) {
+             check( rescale( itr->token_bucket, sym ).amount > 0, "token bucket too small for new precision" );
+          }
+          migtable.set( migration_stats{ maximum_supply, asset{ 0, st.supply.symbol }, asset{ 0, sym }, 0, name() },
+                        issuer );
+          statstable.modify (st, issuer, [&]( auto& s ) {
+             s.issuer        = issuer;
+          });
+       } else {
+          statstable.modify (st, issuer, [&]( auto& s ) {
+             s.supply.symbol = maximum_supply.symbol;
+             s.max_supply    = maximum_supply;
+             s.issuer        = issuer;
+          });
+       }
+       bool new_withdraw_to = cf.withdraw_to != withdraw_to;
        cf.membership_mgr = membership_mgr;
        cf.withdrawal_mgr = withdrawal_mgr;
        cf.withdraw_to   = withdraw_to;
@@ -65,6 +125,10 @@ void token::create( const name&   issuer,
        cf.redeem_locked_until = redeem_locked_until;
        cf.config_locked_until = config_locked_until;
        configtable.set( cf, issuer );
+       set_hot_config( st, cf, issuer, migrating ? hot_migrating : 0 );
+       if( new_withdraw_to ) {
+          reset_circulating( sym.code() );
+       }
     return;
     }
     // new token
@@ -85,9 +149,11 @@ void token::create( const name&   issuer,
        .approved      = false
     };
     configtable.set( new_config, issuer );
-    displays displaytable( get_self(), sym.code().raw() );
-    currency_display new_display{ "", "", "", "", "", "" };
-    displaytable.set( new_display, issuer );
+    set_hot_config( *statstable.find( sym.code().raw() ), new_config, issuer );
+    if constexpr( with_display ) {
+       displayrefs reftable( get_self(), sym.code().raw() );
+       reftable.set( display_refs{ "", 0, 0, 0, 0, 0 }, issuer );
+    }
 }
 
 void token::approve( const symbol_code& symbolcode, const bool& reject_and_clear )
@@ -98,23 +164,56 @@ void token::approve( const symbol_code& symbolcode, const bool& reject_and_clear
     const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
     configs configtable( get_self(), sym_code_raw );
     auto cf = configtable.get();
-    displays displaytable( get_self(), sym_code_raw );
     if( reject_and_clear ) {
        check( st.supply.amount == 0, "cannot clear with outstanding tokens" );
-       stakes stakestable( get_self(), sym_code_raw );
-       for( auto itr = stakestable.begin(); itr != stakestable.end(); ) {
-          itr = stakestable.erase(itr);
+       uint32_t budget = max_reject_erase;
+       bool cleared = erase_rows( checkpoints( get_self(), sym_code_raw ), budget );
+       cleared = erase_rows( ratebuckets( get_self(), sym_code_raw ), budget ) && cleared;
+       cleared = erase_rows( feeshards( get_self(), sym_code_raw ), budget ) && cleared;
+       // allowances and schedules must not carry over to a token later created with the same code
+       cleared = erase_rows( allowances( get_self(), sym_code_raw ), budget ) && cleared;
+       cleared = erase_rows( schedules( get_self(), sym_code_raw ), budget ) && cleared;
+       cleared = erase_rows( holders( get_self(), sym_code_raw ), budget ) && cleared;
+       cleared = erase_rows( recents( get_self(), sym_code_raw ), budget ) && cleared;
+       if constexpr( with_staking ) {
+          cleared = erase_rows( settlements( get_self(), sym_code_raw ), budget ) && cleared;
+       }
+       if( !cleared ) {
+          print( "rejecting ", symbolcode, ": more rows remain\n" );
+          return;
+       }
+       if constexpr( with_staking ) {
+          stakes stakestable( get_self(), sym_code_raw );
+          for( auto itr = stakestable.begin(); itr != stakestable.end(); ) {
+             itr = stakestable.erase(itr);
+          }
+          escrows escrowtable( get_self(), sym_code_raw );
+          for( auto itr = escrowtable.begin(); itr != escrowtable.end(); ) {
+             itr = escrowtable.erase(itr);
+          }
        }
        configtable.remove( );
-       displaytable.remove( );
+       hotconfigs( get_self(), sym_code_raw ).remove( );
+       tokenstats( get_self(), sym_code_raw ).remove( );
+       ckconfigs( get_self(), sym_code_raw ).remove( );
+       ratelimits( get_self(), sym_code_raw ).remove( );
+       feeconfigs( get_self(), sym_code_raw ).remove( );
+       recentheads( get_self(), sym_code_raw ).remove( );
+       if constexpr( with_display ) {
+          displays( get_self(), sym_code_raw ).remove( );
+          release_display( sym_code_raw );
+       }
        statstable.erase( statstable.iterator_to(st) );
+       print( "rejected ", symbolcode, "\n" );
     } else {
        cf.approved = true;
-       configtable.set (cf, st.issuer );
+       configtable.set( cf, same_payer );
+       set_hot_config( st, cf, get_self() );
     }
 
 }
 
+#if RAINBOW_STAKING
 void token::setstake( const name&   issuer,
                       const asset&  token_bucket,
                       const asset&  stake_per_bucket,
@@ -163,7 +262,7 @@ void token::setstake( const name&   issuer,
                         stake_per_bucket.amount == 0;
        if( st.supply.amount != 0 ) {
           if( destaking && !deferred) {
-             unstake_one( sk, st.issuer, st.supply );
+             unstake_one( sk, st.issuer, st.supply, st.supply );
           } else if ( restaking ) {
              check( sk.stake_per_bucket.amount == 0, "must destake before restaking");
              if( stake_to == deletestakeacct ) {
@@ -179,8 +278,11 @@ void token::setstake( const name&   issuer,
           s.deferred = deferred;
           s.proportional = proportional;
        });
-       if( restaking && !deferred ) {
-          stake_one( sk, st.issuer, st.supply );
+       if( restaking ) {
+          reset_escrow( sk );
+          if( !deferred ) {
+             stake_one( sk, st.issuer, st.supply );
+          }
        }
        return;
     }
@@ -197,12 +299,15 @@ void token::setstake( const name&   issuer,
        s.deferred             = deferred;
        s.proportional         = proportional;
     });
+    reset_escrow( sk );
     if( st.supply.amount != 0 ) {
        stake_one( sk, st.issuer, st.supply );
     }
 
 }
+#endif
 
+#if RAINBOW_DISPLAY
 void token::setdisplay( const name&         issuer,
                         const symbol_code&  symbolcode,
                         const string&       token_name,
@@ -214,24 +319,89 @@ void token::setdisplay( const name&         issuer,
 {
     require_auth( issuer );
     auto sym_code_raw = symbolcode.raw();
-    displays displaytable( get_self(), sym_code_raw );
-    auto dt = displaytable.get();
+    stats statstable( get_self(), sym_code_raw );
+    const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+    check( st.issuer == issuer, "mismatched issuer account" );
     check( token_name.size() <= 32, "name has more than 32 bytes" );
     const string *url_list[] = { &logo, &logo_lg, &web_link, &background };
     for( const string* s : url_list ) {
        check( s->size() <= 256, "url string has more than 256 bytes" );
     }
     check( json_meta.size() <= 1024, "json metadata has more than 1024 bytes" );
-    dt.name        = token_name;
-    dt.logo        = logo;
-    dt.logo_lg     = logo_lg;
-    dt.web_link    = web_link;
-    dt.background  = background;
-    dt.json_meta   = json_meta;
-    displaytable.set( dt, issuer );
+    // new references are taken before the old ones are dropped, so unchanged strings keep their blobs
+    display_refs dr{
+       .name       = token_name,
+       .logo       = add_blob( logo, issuer ),
+       .logo_lg    = add_blob( logo_lg, issuer ),
+       .web_link   = add_blob( web_link, issuer ),
+       .background = add_blob( background, issuer ),
+       .json_meta  = add_blob( json_meta, issuer )
+    };
+    release_display( sym_code_raw );
+    displayrefs( get_self(), sym_code_raw ).set( dr, issuer );
+    // strings stored inline by earlier versions
+    displays( get_self(), sym_code_raw ).remove( );
+}
+#endif
+
+uint64_t token::add_blob( const string& data, const name& payer ) {
+    if( data.empty() ) {
+       return 0;
+    }
+    auto hash = sha256( data.data(), data.size() );
+    blobs blobtable( get_self(), get_self().value );
+    auto hash_index = blobtable.get_index<"byhash"_n>();
+    auto itr = hash_index.find( hash );
+    if( itr != hash_index.end() ) {
+       // a shared blob stays billed to whoever stored it first
+       hash_index.modify( itr, same_payer, [&]( auto& b ) {
+          b.refs++;
+       });
+       return itr->id;
+    }
+    return blobtable.emplace( payer, [&]( auto& b ) {
+       b.id   = std::max( blobtable.available_primary_key(), uint64_t(1) );
+       b.hash = hash;
+       b.data = data;
+       b.refs = 1;
+    })->id;
+}
+
+void token::release_blob( uint64_t id ) {
+    if( id == 0 ) {
+       return;
+    }
+    blobs blobtable( get_self(), get_self().value );
+    auto itr = blobtable.find( id );
+    check( itr != blobtable.end(), "blob not found" );
+    if( itr->refs > 1 ) {
+       blobtable.modify( itr, same_payer, [&]( auto& b ) {
+          b.refs--;
+       });
+    } else {
+       blobtable.erase( itr );
+    }
+}
+
+void token::release_display( uint64_t sym_code_raw ) {
+    displayrefs reftable( get_self(), sym_code_raw );
+    if( !reftable.exists() ) {
+       return;
+    }
+    const auto dr = reftable.get();
+    for( auto id : { dr.logo, dr.logo_lg, dr.web_link, dr.background, dr.json_meta } ) {
+       release_blob( id );
+    }
+    reftable.remove();
 }
 
 void token::issue( const asset& quantity, const string& memo )
+{
+    auto issuer = add_supply( quantity, memo );
+    add_balance( issuer, quantity, issuer, memo );
+}
+
+name token::add_supply( const asset& quantity, const string& memo )
 {
     auto sym = quantity.symbol;
     check( sym.is_valid(), "invalid symbol name" );
@@ -242,6 +412,7 @@ void token::issue( const asset& quantity, const string& memo )
     configs configtable( get_self(), sym.code().raw() );
     const auto& cf = configtable.get();
     check( cf.approved, "cannot issue until token is approved" );
+    check( !migrations( get_self(), sym.code().raw() ).exists(), "token is migrating" );
     require_auth( st.issuer );
     check( quantity.is_valid(), "invalid quantity" );
     check( quantity.amount > 0, "must issue positive quantity" );
@@ -254,13 +425,123 @@ void token::issue( const asset& quantity, const string& memo )
     });
 
     stake_all( st.issuer, quantity );
-    add_balance( st.issuer, quantity, st.issuer );
+    return st.issuer;
+}
+
+void token::setdrop( const asset& total, const checksum256& root, const uint64_t& leaves, const string& memo )
+{
+    check( leaves > 0 && leaves <= max_drop_leaves, "leaf count out of range" );
+    auto issuer = add_supply( total, memo );
+    airdrops droptable( get_self(), total.symbol.code().raw() );
+    const auto& drop = *droptable.emplace( issuer, [&]( auto& d ) {
+       d.id        = droptable.available_primary_key();
+       d.root      = root;
+       d.remaining = total;
+       d.leaves    = leaves;
+    });
+    print( "airdrop ", drop.id, "\n" );
+}
+
+void token::claim( const symbol_code& symbolcode, const uint64_t& drop_id, const uint64_t& index,
+                   const name& owner, const asset& amount, const std::vector<checksum256>& proof )
+{
+    require_auth( owner );
+    check( proof.size() <= max_proof_length, "proof too long" );
+    auto sym_code_raw = symbolcode.raw();
+    airdrops droptable( get_self(), sym_code_raw );
+    auto drop = droptable.find( drop_id );
+    check( drop != droptable.end(), "airdrop not found" );
+    check( index < drop->leaves, "leaf index out of range" );
+    check( amount.symbol == drop->remaining.symbol, "symbol precision mismatch" );
+    check( amount.amount > 0 && amount.amount <= drop->remaining.amount, "invalid claim amount" );
+
+    char leaf[32];
+    datastream<char*> ds( leaf, sizeof(leaf) );
+    ds << index << owner << amount;
+    auto node = sha256( leaf, sizeof(leaf) );
+    for( const auto& sibling : proof ) {
+       node = hash_pair( node, sibling );
+    }
+    check( node == drop->root, "invalid proof" );
+
+    claimed claimtable( get_self(), sym_code_raw );
+    uint64_t row_id = drop_id << 32 | index / claim_bitmap_bits;
+    size_t word = index % claim_bitmap_bits / 64;
+    uint64_t bit = 1ull << index % 64;
+    auto row = claimtable.find( row_id );
+    if( row == claimtable.end() ) {
+       claimtable.emplace( owner, [&]( auto& c ) {
+          c.id = row_id;
+          c.words.resize( claim_bitmap_bits / 64 );
+          c.words[word] = bit;
+       });
+    } else {
+       check( !(row->words[word] & bit), "already claimed" );
+       claimtable.modify( row, same_payer, [&]( auto& c ) {
+          c.words[word] |= bit;
+       });
+    }
+    droptable.modify( drop, same_payer, [&]( auto& d ) {
+       d.remaining -= amount;
+    });
+
+    const auto hc = get_hot_config( sym_code_raw );
+    balance_ledger ledger( get_self() );
+    ledger.set_config( sym_code_raw, hc );
+    if( with_membership && !(hc.flags & hot_allowall) ) {
+       check( ledger.get( owner, amount.symbol ).exists, "owner account must have membership" );
+    }
+    ledger.add( owner, amount, owner );
+    ledger.record( name(), owner, amount, "" );
+    ledger.flush();
+}
+
+void token::enddrop( const symbol_code& symbolcode, const uint64_t& drop_id, const uint32_t& limit )
+{
+    check( limit > 0, "limit must be positive" );
+    auto sym_code_raw = symbolcode.raw();
+    stats statstable( get_self(), sym_code_raw );
+    const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+    require_auth( st.issuer );
+    airdrops droptable( get_self(), sym_code_raw );
+    auto drop = droptable.find( drop_id );
+    check( drop != droptable.end(), "airdrop not found" );
+    if( drop->remaining.amount > 0 ) {
+       add_balance( st.issuer, drop->remaining, st.issuer, "" );
+       droptable.modify( drop, same_payer, [&]( auto& d ) {
+          d.remaining.amount = 0;
+       });
+    }
+    claimed claimtable( get_self(), sym_code_raw );
+    auto itr = claimtable.lower_bound( drop_id << 32 );
+    auto last = claimtable.lower_bound( (drop_id + 1) << 32 );
+    uint32_t counter = 0;
+    for( ; itr != last && counter<limit; counter++ ) {
+       itr = claimtable.erase(itr);
+    }
+    if( itr == last ) {
+       droptable.erase( drop );
+    }
+    print( "enddrop ", drop_id, ": erased ", counter, " claim records, ", itr == last ? "done\n" : "more remain\n" );
+}
+
+checksum256 token::hash_pair( const checksum256& a, const checksum256& b ) {
+    auto lo = std::min( a, b ).extract_as_byte_array();
+    auto hi = std::max( a, b ).extract_as_byte_array();
+    char buf[64];
+    std::copy( lo.begin(), lo.end(), buf );
+    std::copy( hi.begin(), hi.end(), buf + 32 );
+    return sha256( buf, sizeof(buf) );
 }
 
 void token::stake_one( const stake_stats& sk, const name& owner, const asset& quantity ) {
     if( sk.stake_per_bucket.amount > 0 ) {
-       asset stake_quantity = sk.stake_per_bucket;
-       stake_quantity.amount = (int64_t)((int128_t)quantity.amount*sk.stake_per_bucket.amount/sk.token_bucket.amount);
+       asset stake_quantity = stake_amount( sk, quantity );
+       if( sk.proportional ) {
+          escrows escrowtable( get_self(), quantity.symbol.code().raw() );
+          move_escrow( escrowtable, sk, stake_quantity );
+       }
+       RAINBOW_TRACE_PRINT( "stake ", stake_quantity, " ", owner, "->", sk.stake_to, "\n" );
        action(
           permission_level{owner, "active"_n},
           sk.stake_token_contract,
@@ -274,20 +555,43 @@ void token::stake_one( const stake_stats& sk, const name& owner, const asset& qu
 }
 
 void token::stake_all( const name& owner, const asset& quantity ) {
+    if constexpr( !with_staking ) {
+       return;
+    }
     stakes stakestable( get_self(), quantity.symbol.code().raw() );
-    for( auto itr = stakestable.begin(); itr != stakestable.end(); itr++ ) {
+    auto itr = stakestable.begin();
+    if( itr == stakestable.end() ) {
+       return;
+    }
+    bool settle = settlement_mode( quantity.symbol );
+    for( ; itr != stakestable.end(); itr++ ) {
        if( !itr->deferred ) {
-          stake_one( *itr, owner, quantity );
+          if( settle ) {
+             auto stake_quantity = stake_amount( *itr, quantity );
+             if( itr->proportional && itr->stake_per_bucket.amount > 0 ) {
+                escrows escrowtable( get_self(), quantity.symbol.code().raw() );
+                move_escrow( escrowtable, *itr, stake_quantity, false );
+             }
+             accrue_stake( *itr, owner, stake_quantity );
+          } else {
+             stake_one( *itr, owner, quantity );
+          }
        }
     }
 }
 
-void token::unstake_one( const stake_stats& sk, const name& owner, const asset& quantity ) {
+void token::unstake_one( const stake_stats& sk, const name& owner, const asset& quantity,
+                         const asset& supply ) {
     if( sk.stake_per_bucket.amount > 0 ) {
-       asset stake_quantity = sk.stake_per_bucket;
-       stake_quantity.amount = (int64_t)((int128_t)quantity.amount*sk.stake_per_bucket.amount/sk.token_bucket.amount);
-       // TODO (a) if proportional, compute unstake amount based on current escrow balance and note in memo string
-       //      (b) if not proportional, check that escrow is fully funded
+       // an underfunded escrow fails the stake token transfer itself, so the
+       // non-proportional case needs no separate solvency check
+       asset stake_quantity = stake_amount( sk, quantity );
+       if( sk.proportional ) {
+          escrows escrowtable( get_self(), quantity.symbol.code().raw() );
+          stake_quantity = proportional_amount( escrowtable, sk, quantity, supply );
+          move_escrow( escrowtable, sk, -stake_quantity );
+       }
+       RAINBOW_TRACE_PRINT( "unstake ", stake_quantity, " ", sk.stake_to, "->", owner, "\n" );
        action(
           permission_level{sk.stake_to,"active"_n},
           sk.stake_token_contract,
@@ -295,14 +599,137 @@ void token::unstake_one( const stake_stats& sk, const name& owner, const asset&
           std::make_tuple(sk.stake_to,
                           owner,
                           stake_quantity,
-                          std::string("rainbow unstake"))
+                          std::string(sk.proportional ? "rainbow proportional unstake" : "rainbow unstake"))
        ).send();
     }
 }
-void token::unstake_all( const name& owner, const asset& quantity ) {
+void token::unstake_all( const name& owner, const asset& quantity, const asset& supply ) {
+    if constexpr( !with_staking ) {
+       return;
+    }
     stakes stakestable( get_self(), quantity.symbol.code().raw() );
-    for( auto itr = stakestable.begin(); itr != stakestable.end(); itr++ ) {
-       unstake_one( *itr, owner, quantity );
+    auto itr = stakestable.begin();
+    if( itr == stakestable.end() ) {
+       return;
+    }
+    bool settle = settlement_mode( quantity.symbol );
+    for( ; itr != stakestable.end(); itr++ ) {
+       if( settle ) {
+          if( itr->stake_per_bucket.amount > 0 ) {
+             asset stake_quantity = stake_amount( *itr, quantity );
+             if( itr->proportional ) {
+                escrows escrowtable( get_self(), quantity.symbol.code().raw() );
+                stake_quantity = proportional_amount( escrowtable, *itr, quantity, supply );
+                // committed now, so that later redemptions share only what is left
+                move_escrow( escrowtable, *itr, -stake_quantity, false );
+             }
+             accrue_stake( *itr, owner, -stake_quantity );
+          }
+       } else {
+          unstake_one( *itr, owner, quantity, supply );
+       }
+    }
+}
+
+asset token::stake_amount( const stake_stats& sk, const asset& quantity ) const {
+    asset stake_quantity = sk.stake_per_bucket;
+    stake_quantity.amount = (int64_t)((int128_t)quantity.amount*sk.stake_per_bucket.amount/sk.token_bucket.amount);
+    return stake_quantity;
+}
+
+// the retired fraction of supply redeems the same fraction of escrow, counting stake that
+// supply already includes but that is still waiting for a settle
+asset token::proportional_amount( escrows& escrowtable, const stake_stats& sk,
+                                  const asset& quantity, const asset& supply ) {
+    auto e = escrow_row( escrowtable, sk, true );
+    auto escrowed = e->escrowed + e->pending;
+    escrowed.amount = (int64_t)((int128_t)escrowed.amount*quantity.amount/supply.amount);
+    return escrowed;
+}
+
+token::escrows::const_iterator token::escrow_row( escrows& escrowtable, const stake_stats& sk, bool refresh ) {
+    auto itr = escrowtable.find( sk.index );
+    auto now = current_time_point();
+    if( itr != escrowtable.end() &&
+        !( refresh && now.time_since_epoch() - itr->refreshed.time_since_epoch() > escrow_refresh ) ) {
+       return itr;
+    }
+    // cross-contract read of what the escrow account actually holds
+    accounts escrow_acnts( sk.stake_token_contract, sk.stake_to.value );
+    auto bal = escrow_acnts.find( sk.stake_per_bucket.symbol.code().raw() );
+    int64_t held = bal == escrow_acnts.end() ? 0 : bal->balance.amount;
+    if( itr == escrowtable.end() ) {
+       // stakes row from before the escrows table: assume the escrow holds only this stake
+       return escrowtable.emplace( get_self(), [&]( auto& e ) {
+          e.stake_index = sk.index;
+          e.escrowed    = asset{ held, sk.stake_per_bucket.symbol };
+          e.pending     = asset{ 0, sk.stake_per_bucket.symbol };
+          e.refreshed   = now;
+       });
+    }
+    escrowtable.modify( itr, same_payer, [&]( auto& e ) {
+       e.escrowed.amount = std::min( e.escrowed.amount, held );
+       e.refreshed       = now;
+    });
+    return itr;
+}
+
+void token::move_escrow( escrows& escrowtable, const stake_stats& sk, const asset& delta, bool settled ) {
+    escrowtable.modify( escrow_row( escrowtable, sk, false ), same_payer, [&]( auto& e ) {
+       (settled ? e.escrowed : e.pending) += delta;
+    });
+}
+
+void token::reset_escrow( const stake_stats& sk ) {
+    escrows escrowtable( get_self(), sk.token_bucket.symbol.code().raw() );
+    auto itr = escrowtable.find( sk.index );
+    if( itr != escrowtable.end() ) {
+       escrowtable.erase( itr );
+    }
+    if( sk.proportional ) {
+       escrowtable.emplace( get_self(), [&]( auto& e ) {
+          e.stake_index = sk.index;
+          e.escrowed    = asset{ 0, sk.stake_per_bucket.symbol };
+          e.pending     = asset{ 0, sk.stake_per_bucket.symbol };
+          e.refreshed   = current_time_point();
+       });
+    }
+}
+
+bool token::settlement_mode( const symbol& sym ) const {
+    hotconfigs hottable( get_self(), sym.code().raw() );
+    return hottable.exists() && (hottable.get().flags & hot_settle);
+}
+
+void token::accrue_stake( const stake_stats& sk, const name& owner, const asset& stake_quantity ) {
+    if( stake_quantity.amount == 0 ) {
+       return;
+    }
+    settlements settletable( get_self(), sk.token_bucket.symbol.code().raw() );
+    auto stake_owner_index = settletable.get_index<"stakeowner"_n>();
+    uint128_t stake_owner = (uint128_t)sk.index<<64 | owner.value;
+    // a stakes row keeps its index when setstake moves it to another escrow; stakes and
+    // redemptions of the owner net out in one row per escrow
+    auto itr = stake_owner_index.lower_bound( stake_owner );
+    while( itr != stake_owner_index.end() && itr->by_stake_owner() == stake_owner &&
+           itr->stake_to != sk.stake_to ) {
+       itr++;
+    }
+    if( itr == stake_owner_index.end() || itr->by_stake_owner() != stake_owner ) {
+       settletable.emplace( owner, [&]( auto& s ) {
+          s.id                   = settletable.available_primary_key();
+          s.stake_index          = sk.index;
+          s.owner                = owner;
+          s.stake_token_contract = sk.stake_token_contract;
+          s.stake_to             = sk.stake_to;
+          s.amount               = stake_quantity;
+       });
+    } else if( itr->amount + stake_quantity == asset{ 0, stake_quantity.symbol } ) {
+       stake_owner_index.erase( itr );
+    } else {
+       stake_owner_index.modify( itr, same_payer, [&]( auto& s ) {
+          s.amount += stake_quantity;
+       });
     }
 }
 
@@ -321,18 +748,20 @@ void token::retire( const name& owner, const asset& quantity, const string& memo
     } else {
        check( owner == st.issuer, "bearer redeem is disabled");
     }
+    check( !migrations( get_self(), sym.code().raw() ).exists(), "token is migrating" );
     require_auth( owner );
     check( quantity.is_valid(), "invalid quantity" );
     check( quantity.amount > 0, "must retire positive quantity" );
 
     check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
 
+    const asset supply = st.supply;
     statstable.modify( st, same_payer, [&]( auto& s ) {
        s.supply -= quantity;
     });
 
-    sub_balance( owner, quantity );
-    unstake_all( owner, quantity );
+    sub_balance( owner, quantity, memo );
+    unstake_all( owner, quantity, supply );
 }
 
 void token::transfer( const name&    from,
@@ -344,15 +773,15 @@ void token::transfer( const name&    from,
     check( is_account( from ), "from account does not exist");
     check( is_account( to ), "to account does not exist");
     auto sym_code_raw = quantity.symbol.code().raw();
-    stats statstable( get_self(), sym_code_raw );
-    const auto& st = statstable.get( sym_code_raw );
-    configs configtable( get_self(), sym_code_raw );
-    const auto& cf = configtable.get();
+    const auto hc = get_hot_config( sym_code_raw );
+    check( !(hc.flags & hot_migrating), "token is migrating" );
 
-    if( cf.membership_mgr != allowallacct ) {
-       accounts to_acnts( get_self(), to.value );
-       auto to = to_acnts.find( sym_code_raw );
-       check( to != to_acnts.end(), "to account must have membership");
+    // the recipient row found for the membership check is reused for the credit
+    balance_ledger ledger( get_self() );
+    ledger.set_config( sym_code_raw, hc );
+    const auto& to_bal = ledger.get( to, quantity.symbol );
+    if( with_membership && !(hc.flags & hot_allowall) ) {
+       check( to_bal.exists, "to account must have membership");
     }
 
     require_recipient( from );
@@ -360,136 +789,1613 @@ void token::transfer( const name&    from,
 
     check( quantity.is_valid(), "invalid quantity" );
     check( quantity.amount > 0, "must transfer positive quantity" );
-    check( quantity.symbol == st.supply.symbol, "symbol precision mismatch" );
+    check( quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
     check( memo.size() <= 256, "memo has more than 256 bytes" );
 
-    bool withdrawing = has_auth( cf.withdrawal_mgr ) && to == cf.withdraw_to;
+    asset fee{ 0, quantity.symbol };
+    bool withdrawing = with_withdrawal && has_auth( hc.withdrawal_mgr ) && to == hc.withdraw_to;
     if (!withdrawing ) {
        require_auth( from );
-       if( from != st.issuer ) {
-          check( !cf.transfers_frozen, "transfers are frozen");
-       }
-       // TBD: implement token.seeds check_limit_transactions(from) ?
+       fee = ledger.send( from, quantity, from );
     }
 
     auto payer = has_auth( to ) ? to : from;
 
-    sub_balance( from, quantity );
-    add_balance( to, quantity, payer );
+    ledger.sub( from, quantity + fee );
+    ledger.add( to, quantity, payer );
+    ledger.count_transfer( sym_code_raw );
+    ledger.record( from, to, quantity, memo );
+    ledger.flush();
 }
 
-void token::sub_balance( const name& owner, const asset& value ) {
-   accounts from_acnts( get_self(), owner.value );
+void token::transfers( const std::vector<transfer_args>& batch )
+{
+    check( !batch.empty(), "empty transfer batch" );
+    std::map<uint64_t, hot_config> tokens;
+    std::set<name> known_accounts;
+    balance_ledger ledger( get_self() );
 
-   const auto& from = from_acnts.get( value.symbol.code().raw(), "no balance object found" );
-   check( from.balance.amount >= value.amount, "overdrawn balance" );
+    for( const auto& t : batch ) {
+       check( t.from != t.to, "cannot transfer to self" );
+       if( known_accounts.insert( t.from ).second ) {
+          check( is_account( t.from ), "from account does not exist");
+       }
+       if( known_accounts.insert( t.to ).second ) {
+          check( is_account( t.to ), "to account does not exist");
+       }
+       auto sym_code_raw = t.quantity.symbol.code().raw();
+       auto tk = tokens.find( sym_code_raw );
+       if( tk == tokens.end() ) {
+          tk = tokens.emplace( sym_code_raw, get_hot_config( sym_code_raw ) ).first;
+          ledger.set_config( sym_code_raw, tk->second );
+       }
+       const auto& hc = tk->second;
+       check( !(hc.flags & hot_migrating), "token is migrating" );
 
-   from_acnts.modify( from, same_payer, [&]( auto& a ) {
-         a.balance -= value;
-      });
+       check( t.quantity.is_valid(), "invalid quantity" );
+       check( t.quantity.amount > 0, "must transfer positive quantity" );
+       check( t.quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
+       check( t.memo.size() <= 256, "memo has more than 256 bytes" );
+
+       if( with_membership && !(hc.flags & hot_allowall) ) {
+          check( ledger.get( t.to, t.quantity.symbol ).exists, "to account must have membership");
+       }
+
+       require_recipient( t.from );
+       require_recipient( t.to );
+
+       asset fee{ 0, t.quantity.symbol };
+       bool withdrawing = with_withdrawal && has_auth( hc.withdrawal_mgr ) && t.to == hc.withdraw_to;
+       if (!withdrawing ) {
+          require_auth( t.from );
+          fee = ledger.send( t.from, t.quantity, t.from );
+       }
+
+       ledger.sub( t.from, t.quantity + fee );
+       ledger.add( t.to, t.quantity, has_auth( t.to ) ? t.to : t.from );
+       ledger.count_transfer( sym_code_raw );
+       ledger.record( t.from, t.to, t.quantity, t.memo );
+    }
+    ledger.flush();
 }
 
-void token::add_balance( const name& owner, const asset& value, const name& ram_payer )
+void token::setallowance( const name&            owner,
+                          const name&            spender,
+                          const asset&           quantity,
+                          const time_point_sec&  expiry )
 {
-   accounts to_acnts( get_self(), owner.value );
-   auto to = to_acnts.find( value.symbol.code().raw() );
-   if( to == to_acnts.end() ) {
-      to_acnts.emplace( ram_payer, [&]( auto& a ){
-        a.balance = value;
-      });
-   } else {
-      to_acnts.modify( to, same_payer, [&]( auto& a ) {
-        a.balance += value;
-      });
-   }
+    require_auth( owner );
+    check( owner != spender, "cannot give an allowance to self" );
+    check( is_account( spender ), "spender account does not exist" );
+    auto sym_code_raw = quantity.symbol.code().raw();
+    const auto hc = get_hot_config( sym_code_raw );
+    check( !(hc.flags & hot_migrating), "token is migrating" );
+    check( quantity.is_valid(), "invalid quantity" );
+    check( quantity.amount >= 0, "allowance must be non-negative" );
+    check( quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
+
+    allowances allowtable( get_self(), sym_code_raw );
+    auto owner_spender_index = allowtable.get_index<"ownerspender"_n>();
+    auto row = owner_spender_index.find( (uint128_t)owner.value<<64 | spender.value );
+    if( quantity.amount == 0 ) {
+       if( row != owner_spender_index.end() ) {
+          owner_spender_index.erase( row );
+       }
+       return;
+    }
+    check( expiry > time_point_sec( current_time_point() ), "expiry must be in the future" );
+    if( row == owner_spender_index.end() ) {
+       allowtable.emplace( owner, [&]( auto& a ) {
+          a.id        = allowtable.available_primary_key();
+          a.owner     = owner;
+          a.spender   = spender;
+          a.remaining = quantity;
+          a.expiry    = expiry;
+       });
+    } else {
+       owner_spender_index.modify( row, same_payer, [&]( auto& a ) {
+          a.remaining = quantity;
+          a.expiry    = expiry;
+       });
+    }
 }
 
-void token::open( const name& owner, const symbol_code& symbolcode, const name& ram_payer )
+void token::transferfrom( const name&    spender,
+                          const name&    from,
+                          const name&    to,
+                          const asset&   quantity,
+                          const string&  memo )
 {
-   require_auth( ram_payer );
+    require_auth( spender );
+    check( is_account( from ), "from account does not exist");
+    check( is_account( to ), "to account does not exist");
+    auto sym_code_raw = quantity.symbol.code().raw();
+    const auto hc = get_hot_config( sym_code_raw );
+
+    balance_ledger ledger( get_self() );
+    ledger.set_config( sym_code_raw, hc );
+    pull( ledger, hc, spender, { from, to, quantity, memo } );
+    ledger.flush();
+}
 
-   check( is_account( owner ), "owner account does not exist" );
+void token::pullmany( const name& spender, const std::vector<transfer_args>& batch )
+{
+    require_auth( spender );
+    check( !batch.empty(), "empty transfer batch" );
+    std::map<uint64_t, hot_config> tokens;
+    std::set<name> known_accounts;
+    balance_ledger ledger( get_self() );
 
-   auto sym_code_raw = symbolcode.raw();
-   stats statstable( get_self(), sym_code_raw );
-   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
-   configs configtable( get_self(), sym_code_raw );
-   const auto& cf = configtable.get();
-   if( cf.membership_mgr != allowallacct) {
-      require_auth( cf.membership_mgr );
-   }
-   accounts acnts( get_self(), owner.value );
-   auto it = acnts.find( sym_code_raw );
-   if( it == acnts.end() ) {
-      acnts.emplace( ram_payer, [&]( auto& a ){
-        a.balance = asset{0, st.supply.symbol};
-      });
-   }
+    for( const auto& t : batch ) {
+       if( known_accounts.insert( t.from ).second ) {
+          check( is_account( t.from ), "from account does not exist");
+       }
+       if( known_accounts.insert( t.to ).second ) {
+          check( is_account( t.to ), "to account does not exist");
+       }
+       auto sym_code_raw = t.quantity.symbol.code().raw();
+       auto tk = tokens.find( sym_code_raw );
+       if( tk == tokens.end() ) {
+          tk = tokens.emplace( sym_code_raw, get_hot_config( sym_code_raw ) ).first;
+          ledger.set_config( sym_code_raw, tk->second );
+       }
+       pull( ledger, tk->second, spender, t );
+    }
+    ledger.flush();
 }
 
-void token::close( const name& owner, const symbol_code& symbolcode )
+void token::schedule( const name&            payer,
+                      const name&            payee,
+                      const asset&           quantity,
+                      const uint32_t&        period,
+                      const time_point_sec&  first_due,
+                      const string&          memo )
 {
-   auto sym_code_raw = symbolcode.raw();
-   stats statstable( get_self(), sym_code_raw );
-   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
-   configs configtable( get_self(), sym_code_raw );
-   const auto& cf = configtable.get();
-   if( cf.membership_mgr == allowallacct || !has_auth( cf.membership_mgr ) ) {
-      require_auth( owner );
-   }
-   accounts acnts( get_self(), owner.value );
-   auto it = acnts.find( sym_code_raw );
-   check( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
-   check( it->balance.amount == 0, "Cannot close because the balance is not zero." );
-   acnts.erase( it );
+    require_auth( payer );
+    check( payer != payee, "cannot transfer to self" );
+    check( is_account( payee ), "to account does not exist");
+    auto sym_code_raw = quantity.symbol.code().raw();
+    const auto hc = get_hot_config( sym_code_raw );
+    check( !(hc.flags & hot_migrating), "token is migrating" );
+    check( quantity.is_valid(), "invalid quantity" );
+    check( quantity.amount > 0, "must transfer positive quantity" );
+    check( quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
+    check( memo.size() <= 256, "memo has more than 256 bytes" );
+    // a crank makes one payment per schedule, so a past due time or short period would let
+    // one schedule pay many periods at once
+    check( first_due >= time_point_sec( current_time_point() ), "first payment must not be due in the past" );
+    check( period == 0 || period >= min_schedule_period, "period is too short" );
+
+    // crank cannot bill RAM to the payer, so the payee's row is opened now
+    accounts acnts( get_self(), payee.value );
+    if( acnts.find( sym_code_raw ) == acnts.end() ) {
+       check( hc.flags & hot_allowall, "to account must have membership" );
+       open_balances( quantity.symbol.code(), { payee }, payer );
+    }
+
+    schedules schedtable( get_self(), sym_code_raw );
+    const auto& sc = *schedtable.emplace( payer, [&]( auto& s ) {
+       s.id       = schedtable.available_primary_key();
+       s.payer    = payer;
+       s.payee    = payee;
+       s.quantity = quantity;
+       s.period   = period;
+       s.next_due = first_due;
+       s.memo     = memo;
+    });
+    print( "schedule ", sc.id, "\n" );
 }
 
-void token::freeze( const symbol_code& symbolcode, const bool& freeze, const string& memo )
+void token::unschedule( const symbol_code& symbolcode, const uint64_t& id )
 {
-   auto sym_code_raw = symbolcode.raw();
-   stats statstable( get_self(), sym_code_raw );
-   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
-   configs configtable( get_self(), sym_code_raw );
-   auto cf = configtable.get();
-   check( memo.size() <= 256, "memo has more than 256 bytes" );
-   require_auth( cf.freeze_mgr );
-   cf.transfers_frozen = freeze;
-   configtable.set (cf, st.issuer );
+    schedules schedtable( get_self(), symbolcode.raw() );
+    const auto& sc = schedtable.get( id, "schedule not found" );
+    if( !has_auth( sc.payee ) ) {
+       require_auth( sc.payer );
+    }
+    schedtable.erase( sc );
 }
 
-void token::resetram( const name& table, const string& scope, const uint32_t& limit )
+void token::crank( const symbol_code& symbolcode, const uint32_t& limit )
 {
-   require_auth2( get_self().value, "active"_n.value );
-   uint64_t scope_raw;
-   check( !scope.empty(), "scope string is empty" );
-   if( isupper(scope.c_str()[0]) ) {
-      symbol_code code(scope);
-      check( code.is_valid(), "invalid symbol code" );
-      scope_raw = code.raw();
-   } else {
-      name n(scope);
-      scope_raw = n.value;
-   }
-   uint32_t counter = 0;
-   if( table == "stakes"_n ) {
-      stakes stakestable( get_self(), scope_raw );
-      for( auto itr = stakestable.begin(); itr != stakestable.end() && counter<limit; counter++ ) {
-         itr = stakestable.erase(itr);
-      }
-   } else if( table == "configs"_n ) {
-      configs configtable( get_self(), scope_raw );
-      configtable.remove();
-   } else {
-     // generic erase for tables with no secondary indices
-     auto it = internal_use_do_not_use::db_lowerbound_i64(_self.value, scope_raw, table.value, 0);
-     while (it >= 0) {
-        auto del = it;
-        uint64_t dummy;
-        it = internal_use_do_not_use::db_next_i64(it, &dummy);
-        internal_use_do_not_use::db_remove_i64(del);
+    check( limit > 0 && limit <= max_crank_count, "limit out of range" );
+    auto sym_code_raw = symbolcode.raw();
+    const auto hc = get_hot_config( sym_code_raw );
+    check( !(hc.flags & hot_migrating), "token is migrating" );
+    // a freeze is lifted in time, so payments wait for it rather than being missed
+    check( !(hc.flags & hot_frozen), "transfers are frozen" );
+    schedules schedtable( get_self(), sym_code_raw );
+    auto dueidx = schedtable.get_index<"bydue"_n>();
+    const time_point_sec now = current_time_point();
+    balance_ledger ledger( get_self() );
+    ledger.set_config( sym_code_raw, hc );
+    uint32_t paid = 0, missed = 0;
+    // each payment moves its schedule on, so the next due one is always first in the index
+    for( auto itr = dueidx.begin(); itr != dueidx.end() && itr->next_due <= now && paid + missed < limit;
+         itr = dueidx.begin() ) {
+       const auto& sc = *itr;
+       // schedules made before a precision migration pay the rescaled quantity
+       auto quantity = sc.quantity.symbol == hc.supply_symbol ? sc.quantity : rescale( sc.quantity, hc.supply_symbol );
+       // the contract pays for a new rate limit bucket row, as the payer did not authorize this action
+       std::optional<asset> fee;
+       if( quantity.amount > 0 && ledger.get( sc.payee, quantity.symbol ).exists ) {
+          fee = ledger.try_send( sc.payer, quantity, get_self() );
+       }
+       if( fee ) {
+          require_recipient( sc.payer );
+          require_recipient( sc.payee );
+          ledger.sub( sc.payer, quantity + *fee );
+          ledger.add( sc.payee, quantity, sc.payer );
+          ledger.count_transfer( sym_code_raw );
+          ledger.record( sc.payer, sc.payee, quantity, sc.memo );
+          paid++;
+       } else {
+          RAINBOW_TRACE_PRINT( "missed schedule ", sc.id, "\n" );
+          missed++;
+       }
+       if( sc.period == 0 ) {
+          schedtable.erase( sc );
+       } else {
+          schedtable.modify( sc, same_payer, [&]( auto& s ) {
+             s.quantity  = quantity;
+             s.next_due += s.period;
+          });
+       }
+    }
+    ledger.flush();
+    print( "crank ", symbolcode, ": paid ", paid, ", missed ", missed, "\n" );
+}
+
+void token::vest( const name&            owner,
+                  const asset&           quantity,
+                  const time_point_sec&  start,
+                  const uint32_t&        cliff,
+                  const uint32_t&        duration,
+                  const string&          memo )
+{
+    check( is_account( owner ), "owner account does not exist" );
+    auto sym_code_raw = quantity.symbol.code().raw();
+    const auto hc = get_hot_config( sym_code_raw );
+    require_auth( hc.issuer );
+    check( owner != hc.issuer, "cannot vest to issuer" );
+    check( !(hc.flags & hot_migrating), "token is migrating" );
+    check( quantity.is_valid(), "invalid quantity" );
+    check( quantity.amount > 0, "must vest positive quantity" );
+    check( quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
+    check( memo.size() <= 256, "memo has more than 256 bytes" );
+    check( duration > 0 && cliff <= duration, "invalid vesting period" );
+
+    vestings vesttable( get_self(), sym_code_raw );
+    auto v = vesttable.find( owner.value );
+    if( v == vesttable.end() ) {
+       vesttable.emplace( hc.issuer, [&]( auto& g ) {
+          g.owner    = owner;
+          g.quantity = quantity;
+          g.start    = start;
+          g.cliff    = cliff;
+          g.duration = duration;
+       });
+    } else {
+       check( locked_amount( *v, current_time_point() ) == 0, "owner already has a vesting grant" );
+       vesttable.modify( v, same_payer, [&]( auto& g ) {
+          g.quantity = quantity;
+          g.start    = start;
+          g.cliff    = cliff;
+          g.duration = duration;
+       });
+    }
+    if( !(hc.flags & hot_vesting) ) {
+       hotconfigs hottable( get_self(), sym_code_raw );
+       auto flagged = hc;
+       flagged.flags |= hot_vesting;
+       write_hot_config( hottable, flagged, hc.issuer );
+    }
+
+    balance_ledger ledger( get_self() );
+    ledger.set_config( sym_code_raw, hc );
+    if( with_membership && !(hc.flags & hot_allowall) ) {
+       check( ledger.get( owner, quantity.symbol ).exists, "owner account must have membership" );
     }
-  }
+    require_recipient( owner );
+    ledger.sub( hc.issuer, quantity );
+    ledger.add( owner, quantity, hc.issuer );
+    ledger.count_transfer( sym_code_raw );
+    ledger.record( hc.issuer, owner, quantity, memo );
+    ledger.flush();
+}
+
+void token::endvest( const name& owner, const symbol_code& symbolcode )
+{
+    auto sym_code_raw = symbolcode.raw();
+    stats statstable( get_self(), sym_code_raw );
+    const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+    require_auth( st.issuer );
+    vestings vesttable( get_self(), sym_code_raw );
+    const auto& v = vesttable.get( owner.value, "no vesting grant" );
+    vesttable.erase( v );
+}
+
+token::token_state token::get_token_state( uint64_t sym_code_raw ) const {
+    stats statstable( get_self(), sym_code_raw );
+    configs configtable( get_self(), sym_code_raw );
+    return token_state{ statstable.get( sym_code_raw ), configtable.get() };
+}
+
+token::hot_config token::get_hot_config( uint64_t sym_code_raw ) const {
+    hotconfigs hottable( get_self(), sym_code_raw );
+    if( hottable.exists() ) {
+       return hottable.get();
+    }
+    // token created before the hotconfig table; the next create, approve or freeze adds it
+    const auto tk = get_token_state( sym_code_raw );
+    return make_hot_config( tk.st, tk.cf );
+}
+
+token::hot_config token::make_hot_config( const currency_stats& st, const currency_config& cf ) const {
+    return hot_config{
+       .supply_symbol  = st.supply.symbol,
+       .issuer         = st.issuer,
+       .withdrawal_mgr = cf.withdrawal_mgr,
+       .withdraw_to    = cf.withdraw_to,
+       .flags          = (cf.membership_mgr == allowallacct ? hot_allowall : 0) |
+                         (cf.transfers_frozen ? hot_frozen : 0) |
+                         (cf.approved ? hot_approved : 0)
+    };
+}
+
+void token::set_hot_config( const currency_stats& st, const currency_config& cf, const name& ram_payer,
+                            uint32_t options ) {
+    hotconfigs hottable( get_self(), st.supply.symbol.code().raw() );
+    auto hc = make_hot_config( st, cf );
+    hc.flags |= options;
+    if( hottable.exists() ) {
+       hc.flags |= hottable.get().flags & hot_options;
+    }
+    write_hot_config( hottable, hc, ram_payer );
+}
+
+// the row is written by actions the issuer need not authorize (approve, freeze), so it keeps
+// whoever paid for it; `ram_payer` pays only when it is first written and must authorize
+void token::write_hot_config( hotconfigs& hottable, const hot_config& hc, const name& ram_payer ) {
+    hottable.set( hc, hottable.exists() ? same_payer : ram_payer );
+}
+
+token::pending_balance& token::balance_ledger::get( const name& owner, const symbol& sym ) {
+   auto key = std::make_pair( owner.value, sym.code().raw() );
+   auto pb = _balances.find( key );
+   if( pb == _balances.end() ) {
+      auto& acnts = _tables.try_emplace( owner.value, _self, owner.value ).first->second;
+      auto row = acnts.find( sym.code().raw() );
+      bool exists = row != acnts.end();
+      asset balance = exists ? row->balance : asset{ 0, sym };
+      if( exists && balance.symbol != sym ) {
+         // a balance a precision migration did not reach; rewritten on flush
+         balance = rescale( balance, sym );
+      }
+      pb = _balances.emplace( key, pending_balance{ row, balance, balance.amount, exists, name(), -1 } ).first;
+   }
+   return pb->second;
+}
+
+const token::hot_config& token::balance_ledger::config( uint64_t sym_code_raw ) {
+   auto cf = _configs.find( sym_code_raw );
+   if( cf == _configs.end() ) {
+      // only the option flags, issuer and withdraw_to are used here, so no fallback to stat and configs
+      hotconfigs hottable( _self, sym_code_raw );
+      cf = _configs.emplace( sym_code_raw, hottable.get_or_default( hot_config{} ) ).first;
+   }
+   return cf->second;
+}
+
+const token::checkpoint_config& token::balance_ledger::checkpoint_settings( uint64_t sym_code_raw ) {
+   auto ck = _checkpoint_configs.find( sym_code_raw );
+   if( ck == _checkpoint_configs.end() ) {
+      ckconfigs cktable( _self, sym_code_raw );
+      ck = _checkpoint_configs.emplace( sym_code_raw, cktable.get() ).first;
+   }
+   return ck->second;
+}
+
+void token::balance_ledger::count_transfer( uint64_t sym_code_raw ) {
+   if( config( sym_code_raw ).flags & hot_tokenstats ) {
+      _deltas[sym_code_raw].transfers++;
+   }
+}
+
+int64_t token::balance_ledger::locked( const name& owner, const symbol& sym ) {
+   auto& pb = get( owner, sym );
+   if( pb.locked < 0 ) {
+      pb.locked = 0;
+      if( pb.exists && (config( sym.code().raw() ).flags & hot_vesting) ) {
+         vestings vesttable( _self, sym.code().raw() );
+         auto v = vesttable.find( owner.value );
+         if( v != vesttable.end() ) {
+            // grants made before a precision migration are kept in the old precision
+            asset unvested{ locked_amount( *v, current_time_point() ), v->quantity.symbol };
+            pb.locked = rescale( unvested, sym ).amount;
+         }
+      }
+   }
+   return pb.locked;
+}
+
+void token::balance_ledger::record( const name& from, const name& to, const asset& quantity, const string& memo ) {
+   if( config( quantity.symbol.code().raw() ).flags & hot_recent ) {
+      // numbered when flushed, once the recenthead row has been read
+      _recent.push_back( recent_transfer{ .slot = 0, .seq = 0, .from = from, .to = to, .quantity = quantity,
+                                          .memo_hash = sha256( memo.data(), memo.size() ) } );
+   }
+}
+
+asset token::balance_ledger::send( const name& from, const asset& quantity, const name& ram_payer ) {
+   asset fee{ 0, quantity.symbol };
+   if( auto error = charge_sender( from, quantity, ram_payer, std::numeric_limits<int64_t>::max(), fee ) ) {
+      check( false, error );
+   }
+   return fee;
+}
+
+std::optional<asset> token::balance_ledger::try_send( const name& from, const asset& quantity, const name& ram_payer ) {
+   asset fee{ 0, quantity.symbol };
+   const auto& bal = get( from, quantity.symbol );
+   if( !bal.exists ||
+       charge_sender( from, quantity, ram_payer, bal.balance.amount - locked( from, quantity.symbol ), fee ) ) {
+      return std::nullopt;
+   }
+   return fee;
+}
+
+// applies the freeze, rate limit and fee of a transfer sent by `from`, or returns why it breaks
+// them, or costs more than `available`, and charges nothing
+const char* token::balance_ledger::charge_sender( const name& from, const asset& quantity, const name& ram_payer,
+                                                  int64_t available, asset& fee ) {
+   const auto& hc = config( quantity.symbol.code().raw() );
+   const bool exempt = from == hc.issuer;
+   if( !exempt ) {
+      if( hc.flags & hot_frozen ) {
+         return "transfers are frozen";
+      }
+      fee = fee_of( from, quantity );
+   }
+   if( quantity.amount > available - fee.amount ) {
+      return "overdrawn balance";
+   }
+   if( !exempt ) {
+      if( auto error = charge_limit( from, quantity, ram_payer ) ) {
+         return error;
+      }
+      accrue_fee( from, fee );
+   }
+   return nullptr;
+}
+
+const char* token::balance_ledger::charge_limit( const name& owner, const asset& quantity, const name& ram_payer ) {
+   auto sym_code_raw = quantity.symbol.code().raw();
+   if( !(config( sym_code_raw ).flags & hot_ratelimit) ) {
+      return nullptr;
+   }
+   auto rl = _rate_limits.find( sym_code_raw );
+   if( rl == _rate_limits.end() ) {
+      rl = _rate_limits.emplace( sym_code_raw, ratelimits( _self, sym_code_raw ).get() ).first;
+   }
+   auto key = std::make_pair( owner.value, sym_code_raw );
+   auto pb = _buckets.find( key );
+   pending_bucket charged;
+   if( pb != _buckets.end() ) {
+      charged = pb->second;
+   } else {
+      auto& buckets = _bucket_tables.try_emplace( sym_code_raw, _self, sym_code_raw ).first->second;
+      auto row = buckets.find( owner.value );
+      auto bucket = row != buckets.end() ? *row : rate_bucket{ owner, time_point(), time_point() };
+      charged = pending_bucket{ row, bucket, ram_payer };
+   }
+   // each allowance is a token bucket kept as the time it is full again: a transfer moves that
+   // time on by its share of the window, and is refused if it would then lie more than a window
+   // ahead; a refused transfer leaves the buckets as they were
+   const auto now = current_time_point();
+   const microseconds window = seconds( rl->second.window );
+   auto charge = [&]( time_point& full, int64_t cost ) {
+      full = std::max( full, now ) + microseconds( cost );
+      return full - now <= window;
+   };
+   auto& b = charged.bucket;
+   if( rl->second.max_transfers > 0 &&
+       !charge( b.count_full, window.count() / rl->second.max_transfers ) ) {
+      return "transfer rate limit exceeded";
+   }
+   if( rl->second.max_volume.amount > 0 ) {
+      // limits set before a precision migration are kept in the old precision
+      auto max_volume = rescale( rl->second.max_volume, quantity.symbol ).amount;
+      if( quantity.amount > max_volume ||
+          !charge( b.volume_full, (int64_t)((int128_t)window.count() * quantity.amount / max_volume) ) ) {
+         return "transfer volume limit exceeded";
+      }
+   }
+   _buckets.insert_or_assign( key, charged );
+   return nullptr;
+}
+
+asset token::balance_ledger::fee_of( const name& owner, const asset& quantity ) {
+   auto sym_code_raw = quantity.symbol.code().raw();
+   asset fee{ 0, quantity.symbol };
+   if( !(config( sym_code_raw ).flags & hot_fees) ) {
+      return fee;
+   }
+   auto fc = _fee_configs.find( sym_code_raw );
+   if( fc == _fee_configs.end() ) {
+      fc = _fee_configs.emplace( sym_code_raw, feeconfigs( _self, sym_code_raw ).get() ).first;
+   }
+   if( owner == fc->second.treasury ) {
+      return fee;
+   }
+   fee.amount = (int64_t)((int128_t)quantity.amount * fc->second.basis_points / 10000);
+   if( fc->second.max_fee.amount > 0 ) {
+      // caps set before a precision migration are kept in the old precision
+      fee.amount = std::min( fee.amount, rescale( fc->second.max_fee, quantity.symbol ).amount );
+   }
+   return fee;
+}
+
+void token::balance_ledger::accrue_fee( const name& owner, const asset& fee ) {
+   if( fee.amount > 0 ) {
+      auto sym_code_raw = fee.symbol.code().raw();
+      auto key = std::make_pair( sym_code_raw, fee_shard_of( owner, _fee_configs.at( sym_code_raw ).shards ) );
+      auto accrued = _fees.try_emplace( key, asset{ 0, fee.symbol } ).first;
+      accrued->second += fee;
+   }
+}
+
+void token::balance_ledger::spend( const name& owner, const name& spender, const asset& quantity ) {
+   auto sym_code_raw = quantity.symbol.code().raw();
+   auto key = std::make_tuple( sym_code_raw, owner.value, spender.value );
+   auto pa = _allowances.find( key );
+   if( pa == _allowances.end() ) {
+      auto& allowtable = _allowance_tables.try_emplace( sym_code_raw, _self, sym_code_raw ).first->second;
+      auto owner_spender_index = allowtable.get_index<"ownerspender"_n>();
+      auto row = owner_spender_index.find( (uint128_t)owner.value<<64 | spender.value );
+      check( row != owner_spender_index.end(), "no allowance for spender" );
+      check( row->expiry > time_point_sec( current_time_point() ), "allowance has expired" );
+      // allowances set before a precision migration are kept in the old precision
+      pa = _allowances.emplace( key, pending_allowance{ row->id, rescale( row->remaining, quantity.symbol ) } ).first;
+   }
+   check( quantity <= pa->second.remaining, "overdrawn allowance" );
+   pa->second.remaining -= quantity;
+}
+
+void token::balance_ledger::sub( const name& owner, const asset& value ) {
+   auto& from = get( owner, value.symbol );
+   check( from.exists, "no balance object found" );
+   check( from.balance.amount >= value.amount, "overdrawn balance" );
+   from.balance -= value;
+   check( from.balance.amount >= locked( owner, value.symbol ), "balance is locked until vested" );
+}
+
+void token::balance_ledger::add( const name& owner, const asset& value, const name& ram_payer ) {
+   auto& to = get( owner, value.symbol );
+   if( !to.exists ) {
+      to.exists = true;
+      to.ram_payer = ram_payer;
+   }
+   to.balance += value;
+}
+
+void token::balance_ledger::flush() {
+   // balances are ordered by owner, so rows of one scope are written together
+   for( auto& [key, pb] : _balances ) {
+      auto& acnts = _tables.at( key.first );
+      bool written = false;
+      bool created = false;
+      int64_t before = pb.original;
+      if( pb.row == acnts.end() ) {
+         if( pb.exists ) {
+            pb.row = acnts.emplace( pb.ram_payer, [&]( auto& a ){
+              a.balance = pb.balance;
+            });
+            written = created = true;
+         }
+      } else if( pb.balance.amount != pb.original || pb.row->balance.symbol != pb.balance.symbol ) {
+         acnts.modify( pb.row, same_payer, [&]( auto& a ) {
+           a.balance = pb.balance;
+         });
+         written = true;
+      }
+      pb.original = pb.balance.amount;
+      if( !written ) {
+         continue;
+      }
+      name owner( key.first );
+      const auto& hc = config( key.second );
+      if( hc.flags & hot_holders ) {
+         index_holder( _self, owner, pb.balance, created ? pb.ram_payer : name() );
+      }
+      if( hc.flags & hot_checkpoints ) {
+         write_checkpoint( _self, owner, before, pb.balance, checkpoint_settings( key.second ) );
+      }
+      if( hc.flags & hot_tokenstats ) {
+         auto& d = _deltas[key.second];
+         bool held = pb.balance.amount > 0;
+         if( created ) {
+            (held ? d.holders : d.zero_rows)++;
+         } else if( held != (before > 0) ) {
+            d.holders   += held ? 1 : -1;
+            d.zero_rows -= held ? 1 : -1;
+         }
+         if( owner != hc.issuer && owner != hc.withdraw_to ) {
+            d.circulating += pb.balance.amount - before;
+         }
+      }
+   }
+   for( const auto& [sym_code_raw, d] : _deltas ) {
+      update_aggregates( _self, sym_code_raw, d );
+   }
+   _deltas.clear();
+   if( !_recent.empty() ) {
+      write_recent();
+   }
+   if( !_buckets.empty() ) {
+      write_buckets();
+   }
+   if( !_fees.empty() ) {
+      write_fees();
+   }
+   if( !_allowances.empty() ) {
+      write_allowances();
+   }
+}
+
+void token::balance_ledger::write_recent() {
+   std::map<uint64_t, recent_head> heads;
+   for( auto& r : _recent ) {
+      auto sym_code_raw = r.quantity.symbol.code().raw();
+      auto head = heads.find( sym_code_raw );
+      if( head == heads.end() ) {
+         head = heads.emplace( sym_code_raw, recentheads( _self, sym_code_raw ).get() ).first;
+      }
+      auto& h = head->second;
+      r.seq  = h.next_seq++;
+      r.slot = r.seq % h.slots;
+      recents recenttable( _self, sym_code_raw );
+      auto row = recenttable.find( r.slot );
+      // the oldest movement is overwritten in place once every slot is used
+      if( row == recenttable.end() ) {
+         recenttable.emplace( _self, [&]( auto& e ) { e = r; } );
+      } else {
+         recenttable.modify( row, same_payer, [&]( auto& e ) { e = r; } );
+      }
+   }
+   for( const auto& [sym_code_raw, h] : heads ) {
+      recentheads( _self, sym_code_raw ).set( h, same_payer );
+   }
+   _recent.clear();
+}
+
+void token::balance_ledger::write_buckets() {
+   for( auto& [key, pb] : _buckets ) {
+      auto& buckets = _bucket_tables.at( key.second );
+      if( pb.row == buckets.end() ) {
+         pb.row = buckets.emplace( pb.ram_payer, [&]( auto& b ) { b = pb.bucket; } );
+      } else {
+         buckets.modify( pb.row, same_payer, [&]( auto& b ) { b = pb.bucket; } );
+      }
+   }
+   _buckets.clear();
+}
+
+void token::balance_ledger::write_fees() {
+   for( const auto& [key, accrued] : _fees ) {
+      feeshards shardtable( _self, key.first );
+      auto row = shardtable.find( key.second );
+      if( row == shardtable.end() ) {
+         shardtable.emplace( _self, [&]( auto& f ) {
+            f.shard   = key.second;
+            f.accrued = accrued;
+         });
+      } else {
+         shardtable.modify( row, same_payer, [&]( auto& f ) {
+            f.accrued += accrued;
+         });
+      }
+   }
+   _fees.clear();
+}
+
+void token::balance_ledger::write_allowances() {
+   for( const auto& [key, pa] : _allowances ) {
+      auto& allowtable = _allowance_tables.at( std::get<0>( key ) );
+      const auto& row = allowtable.get( pa.id );
+      // a used up allowance is erased, returning its RAM to the owner
+      if( pa.remaining.amount == 0 ) {
+         allowtable.erase( row );
+      } else {
+         allowtable.modify( row, same_payer, [&]( auto& a ) {
+            a.remaining = pa.remaining;
+         });
+      }
+   }
+   _allowances.clear();
+}
+
+uint64_t token::fee_shard_of( const name& owner, uint32_t shards ) {
+   // the low bits of short names are all zero, so the shard is taken from the high bits of the
+   // mixed value rather than by remainder
+   return ((owner.value * 0x9e3779b97f4a7c15ull) >> 32) * shards >> 32;
+}
+
+uint32_t token::hot_flags( const name& self, uint64_t sym_code_raw ) {
+   hotconfigs hottable( self, sym_code_raw );
+   return hottable.exists() ? hottable.get().flags : 0;
+}
+
+void token::update_aggregates( const name& self, uint64_t sym_code_raw, const aggregate_delta& delta ) {
+   tokenstats aggtable( self, sym_code_raw );
+   auto ag = aggtable.get();
+   ag.holders            += delta.holders;
+   ag.zero_rows          += delta.zero_rows;
+   ag.circulating.amount += delta.circulating;
+   ag.transfers          += delta.transfers;
+   aggtable.set( ag, same_payer );
+}
+
+void token::reset_circulating( const symbol_code& symbolcode ) {
+   auto sym_code_raw = symbolcode.raw();
+   tokenstats aggtable( get_self(), sym_code_raw );
+   if( !aggtable.exists() ) {
+      return;
+   }
+   const auto tk = get_token_state( sym_code_raw );
+   auto ag = aggtable.get();
+   ag.circulating = tk.st.supply;
+   airdrops droptable( get_self(), sym_code_raw );
+   for( const auto& d : droptable ) {
+      ag.circulating -= d.remaining;
+   }
+   feeshards shardtable( get_self(), sym_code_raw );
+   for( const auto& f : shardtable ) {
+      ag.circulating -= f.accrued;
+   }
+   std::set<name> excluded{ tk.st.issuer, tk.cf.withdraw_to };
+   for( const auto& owner : excluded ) {
+      accounts acnts( get_self(), owner.value );
+      auto row = acnts.find( sym_code_raw );
+      if( row != acnts.end() ) {
+         // either may not have been reached by a precision migration that was ended early
+         ag.circulating.amount -= rescale( row->balance, ag.circulating.symbol ).amount;
+      }
+   }
+   aggtable.set( ag, same_payer );
+}
+
+// a new row is billed to `ram_payer`, the payer of the new accounts row or the issuer; without
+// one, only an existing row is brought up to date
+void token::index_holder( const name& self, const name& owner, const asset& balance, const name& ram_payer ) {
+   holders holdertable( self, balance.symbol.code().raw() );
+   auto row = holdertable.find( owner.value );
+   if( row == holdertable.end() ) {
+      if( !ram_payer ) {
+         return;
+      }
+      holdertable.emplace( ram_payer, [&]( auto& h ) {
+         h.owner   = owner;
+         h.balance = balance;
+      });
+   } else if( row->balance.amount != balance.amount || row->balance.symbol != balance.symbol ) {
+      holdertable.modify( row, same_payer, [&]( auto& h ) {
+         h.balance = balance;
+      });
+   }
+}
+
+void token::unindex_holder( const name& self, const name& owner, const symbol_code& symbolcode ) {
+   holders holdertable( self, symbolcode.raw() );
+   auto row = holdertable.find( owner.value );
+   if( row != holdertable.end() ) {
+      holdertable.erase( row );
+   }
+}
+
+int64_t token::locked_amount( const vesting& v, const time_point_sec& now ) {
+   uint64_t t = now.sec_since_epoch();
+   uint64_t start = v.start.sec_since_epoch();
+   if( t < start + v.cliff ) {
+      return v.quantity.amount;
+   }
+   if( t >= start + v.duration ) {
+      return 0;
+   }
+   return int64_t( (uint128_t)v.quantity.amount * (start + v.duration - t) / v.duration );
+}
+
+void token::write_checkpoint( const name& self, const name& owner, int64_t before, const asset& balance,
+                              const checkpoint_config& ck ) {
+   checkpoints cktable( self, balance.symbol.code().raw() );
+   auto ckidx = cktable.get_index<"ownerepoch"_n>();
+   uint32_t now = current_time_point().sec_since_epoch();
+   uint32_t epoch = now - now % ck.epoch;
+   uint128_t first = (uint128_t)owner.value<<64;
+   auto row = ckidx.lower_bound( first | epoch );
+   if( row != ckidx.end() && row->owner == owner ) {
+      // already written this epoch
+      cktable.modify( *row, same_payer, [&]( auto& c ) {
+         c.balance = balance;
+      });
+      return;
+   }
+   auto emplace = [&]( uint32_t at, const asset& value ) {
+      cktable.emplace( self, [&]( auto& c ) {
+         c.id      = cktable.available_primary_key();
+         c.owner   = owner;
+         c.epoch   = time_point_sec( at );
+         c.balance = value;
+      });
+   };
+   auto oldest = ckidx.lower_bound( first );
+   if( oldest == ckidx.end() || oldest->owner != owner ) {
+      // first change since checkpoints were switched on; keep the balance it replaced
+      emplace( epoch - 1, asset{ before, balance.symbol } );
+   }
+   emplace( epoch, balance );
+   if( ck.retain == 0 || uint64_t(ck.retain) * ck.epoch > epoch ) {
+      return;
+   }
+   // a row is needed only until the next row of the owner is older than the retained history
+   uint32_t horizon = epoch - ck.retain * ck.epoch;
+   for( int pruned = 0; pruned < 2; pruned++ ) {
+      auto oldest = ckidx.lower_bound( first );
+      auto next = oldest;
+      if( ++next == ckidx.end() || next->owner != owner || next->epoch.sec_since_epoch() > horizon ) {
+         break;
+      }
+      cktable.erase( *oldest );
+   }
+}
+
+void token::pull( balance_ledger& ledger, const hot_config& hc, const name& spender, const transfer_args& t ) {
+   check( t.from != t.to, "cannot transfer to self" );
+   check( !(hc.flags & hot_migrating), "token is migrating" );
+   check( t.quantity.is_valid(), "invalid quantity" );
+   check( t.quantity.amount > 0, "must transfer positive quantity" );
+   check( t.quantity.symbol == hc.supply_symbol, "symbol precision mismatch" );
+   check( t.memo.size() <= 256, "memo has more than 256 bytes" );
+
+   if( with_membership && !(hc.flags & hot_allowall) ) {
+      check( ledger.get( t.to, t.quantity.symbol ).exists, "to account must have membership");
+   }
+
+   require_recipient( t.from );
+   require_recipient( t.to );
+
+   // the allowance stands in for the authority of `from`; the fee is not drawn from it
+   ledger.spend( t.from, spender, t.quantity );
+   auto fee = ledger.send( t.from, t.quantity, spender );
+
+   ledger.sub( t.from, t.quantity + fee );
+   ledger.add( t.to, t.quantity, has_auth( t.to ) ? t.to : spender );
+   ledger.count_transfer( t.quantity.symbol.code().raw() );
+   ledger.record( t.from, t.to, t.quantity, t.memo );
+}
+
+void token::sub_balance( const name& owner, const asset& value, const string& memo ) {
+   balance_ledger ledger( get_self() );
+   ledger.sub( owner, value );
+   ledger.record( owner, name(), value, memo );
+   ledger.flush();
+}
+
+void token::add_balance( const name& owner, const asset& value, const name& ram_payer, const string& memo )
+{
+   balance_ledger ledger( get_self() );
+   ledger.add( owner, value, ram_payer );
+   ledger.record( name(), owner, value, memo );
+   ledger.flush();
+}
+
+void token::open( const name& owner, const symbol_code& symbolcode, const name& ram_payer )
+{
+   open_balances( symbolcode, { owner }, ram_payer );
+}
+
+void token::openmany( const symbol_code& symbolcode, const std::vector<name>& owners, const name& ram_payer )
+{
+   check( owners.size() <= max_open_count, "too many owners" );
+   auto opened = open_balances( symbolcode, owners, ram_payer );
+   print( "opened ", opened, " of ", owners.size(), " balances\n" );
+}
+
+uint32_t token::open_balances( const symbol_code& symbolcode, const std::vector<name>& owners,
+                               const name& ram_payer )
+{
+   require_auth( ram_payer );
+
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   if( cf.membership_mgr != allowallacct) {
+      require_auth( cf.membership_mgr );
+   }
+   const asset zero{0, st.supply.symbol};
+   auto flags = hot_flags( get_self(), sym_code_raw );
+   uint32_t opened = 0;
+   for( const auto& owner : owners ) {
+      check( is_account( owner ), "owner account does not exist" );
+      accounts acnts( get_self(), owner.value );
+      auto it = acnts.find( sym_code_raw );
+      if( it != acnts.end() ) {
+         continue;
+      }
+      acnts.emplace( ram_payer, [&]( auto& a ){
+        a.balance = zero;
+      });
+      if( flags & hot_holders ) {
+         index_holder( get_self(), owner, zero, ram_payer );
+      }
+      opened++;
+   }
+   if( opened > 0 && (flags & hot_tokenstats) ) {
+      update_aggregates( get_self(), sym_code_raw, aggregate_delta{ .zero_rows = opened } );
+   }
+   return opened;
+}
+
+void token::close( const name& owner, const symbol_code& symbolcode )
+{
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   if( cf.membership_mgr == allowallacct || !has_auth( cf.membership_mgr ) ) {
+      require_auth( owner );
+   }
+   accounts acnts( get_self(), owner.value );
+   auto it = acnts.find( sym_code_raw );
+   check( it != acnts.end(), "Balance row already deleted or never existed. Action won't have any effect." );
+   check( it->balance.amount == 0, "Cannot close because the balance is not zero." );
+   acnts.erase( it );
+   auto flags = hot_flags( get_self(), sym_code_raw );
+   if( flags & hot_holders ) {
+      unindex_holder( get_self(), owner, symbolcode );
+   }
+   if( flags & hot_tokenstats ) {
+      update_aggregates( get_self(), sym_code_raw, aggregate_delta{ .zero_rows = -1 } );
+   }
+}
+
+void token::sweep( const symbol_code& symbolcode, const uint32_t& limit )
+{
+   check( limit > 0 && limit <= max_sweep_count, "limit out of range" );
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   if( cf.membership_mgr == allowallacct || !has_auth( cf.membership_mgr ) ) {
+      require_auth( st.issuer );
+   }
+   auto flags = hot_flags( get_self(), sym_code_raw );
+   check( flags & hot_holders, "holders option is off" );
+   sweeps sweeptable( get_self(), sym_code_raw );
+   auto sw = sweeptable.get_or_default();
+   holders holdertable( get_self(), sym_code_raw );
+   uint32_t counter = 0;
+   uint32_t closed = 0;
+   auto itr = holdertable.lower_bound( sw.next.value );
+   while( itr != holdertable.end() && counter < limit ) {
+      counter++;
+      if( itr->balance.amount != 0 ) {
+         itr++;
+         continue;
+      }
+      accounts acnts( get_self(), itr->owner.value );
+      auto row = acnts.find( sym_code_raw );
+      if( row != acnts.end() ) {
+         if( row->balance.amount != 0 ) {
+            itr++;
+            continue;
+         }
+         acnts.erase( row );
+         closed++;
+      }
+      itr = holdertable.erase( itr );
+   }
+   sw.closed += closed;
+   if( closed > 0 && (flags & hot_tokenstats) ) {
+      update_aggregates( get_self(), sym_code_raw, aggregate_delta{ .zero_rows = -int64_t(closed) } );
+   }
+   if( itr == holdertable.end() ) {
+      print( "swept ", symbolcode, ": closed ", sw.closed, ", done\n" );
+      sweeptable.remove();
+   } else {
+      sw.next = itr->owner;
+      print( "swept ", symbolcode, ": closed ", sw.closed, ", more remain\n" );
+      sweeptable.set( sw, get_self() );
+   }
+}
+
+void token::freeze( const symbol_code& symbolcode, const bool& freeze, const string& memo )
+{
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "symbol does not exist" );
+   configs configtable( get_self(), sym_code_raw );
+   auto cf = configtable.get();
+   check( memo.size() <= 256, "memo has more than 256 bytes" );
+   require_auth( cf.freeze_mgr );
+   cf.transfers_frozen = freeze;
+   configtable.set( cf, same_payer );
+   set_hot_config( st, cf, get_self() );
+}
+
+void token::setoption( const symbol_code& symbolcode, const name& option, const bool& enabled )
+{
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
+          "token reconfiguration is locked" );
+   uint32_t bit = 0;
+   if( with_staking && option == "settlement"_n ) {
+      bit = hot_settle;
+   } else if( option == "holders"_n ) {
+      bit = hot_holders;
+   } else if( option == "tokenstats"_n ) {
+      bit = hot_tokenstats;
+   }
+   check( bit != 0, "unknown option" );
+   if( bit == hot_tokenstats ) {
+      tokenstats aggtable( get_self(), sym_code_raw );
+      if( enabled ) {
+         // the counts start from zero, so they must start before there is anything to count
+         check( !cf.approved, "tokenstats can only be switched on before approval" );
+         if( !aggtable.exists() ) {
+            aggtable.set( token_aggregates{ 0, 0, asset{ 0, st.supply.symbol }, 0 }, st.issuer );
+         }
+      } else {
+         aggtable.remove();
+      }
+   }
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get_or_default( make_hot_config( st, cf ) );
+   hc.flags = enabled ? hc.flags | bit : hc.flags & ~bit;
+   write_hot_config( hottable, hc, st.issuer );
+}
+
+void token::setcheckpt( const symbol_code& symbolcode, const uint32_t& epoch, const uint32_t& retain )
+{
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
+          "token reconfiguration is locked" );
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get_or_default( make_hot_config( st, cf ) );
+   ckconfigs cktable( get_self(), sym_code_raw );
+   checkpoints ckrows( get_self(), sym_code_raw );
+   if( epoch > 0 ) {
+      // the contract pays for the rows, so each owner may have only a bounded number of them
+      check( epoch >= min_checkpoint_epoch, "epoch is too short" );
+      check( retain > 0 && retain <= max_checkpoint_retain, "retained epochs out of range" );
+      // rows of an earlier setting miss the balance changes made while checkpoints were off
+      check( (hc.flags & hot_checkpoints) || ckrows.begin() == ckrows.end(),
+             "checkpoints of an earlier setting remain; clear them with epoch 0" );
+      cktable.set( checkpoint_config{ .epoch = epoch, .retain = retain }, st.issuer );
+      hc.flags |= hot_checkpoints;
+   } else {
+      cktable.remove();
+      hc.flags &= ~hot_checkpoints;
+      uint32_t counter = 0;
+      auto itr = ckrows.begin();
+      for( ; itr != ckrows.end() && counter<max_checkpoint_erase; counter++ ) {
+         itr = ckrows.erase( itr );
+      }
+      print( "erased ", counter, " checkpoints, ", itr == ckrows.end() ? "done\n" : "more remain\n" );
+   }
+   write_hot_config( hottable, hc, st.issuer );
+}
+
+void token::setrecent( const symbol_code& symbolcode, const uint32_t& slots )
+{
+   check( slots <= max_recent_slots, "too many slots" );
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
+          "token reconfiguration is locked" );
+   recentheads headtable( get_self(), sym_code_raw );
+   auto head = headtable.get_or_default( recent_head{ .next_seq = 0, .slots = 0 } );
+   recents recenttable( get_self(), sym_code_raw );
+   for( auto itr = recenttable.begin(); itr != recenttable.end(); ) {
+      itr = recenttable.erase( itr );
+   }
+   head.slots = slots;
+   headtable.set( head, st.issuer );
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get_or_default( make_hot_config( st, cf ) );
+   hc.flags = slots > 0 ? hc.flags | hot_recent : hc.flags & ~hot_recent;
+   write_hot_config( hottable, hc, st.issuer );
+}
+
+void token::setlimit( const symbol_code& symbolcode, const uint32_t& window, const uint32_t& max_transfers,
+                      const asset& max_volume )
+{
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
+          "token reconfiguration is locked" );
+   check( max_volume.symbol == st.supply.symbol, "symbol precision mismatch" );
+   check( max_volume.amount >= 0, "volume limit must be non-negative" );
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get_or_default( make_hot_config( st, cf ) );
+   ratelimits limittable( get_self(), sym_code_raw );
+   if( window > 0 ) {
+      check( max_transfers > 0 || max_volume.amount > 0, "no limit given" );
+      limittable.set( rate_limit{ .window = window, .max_transfers = max_transfers, .max_volume = max_volume },
+                      st.issuer );
+      hc.flags |= hot_ratelimit;
+   } else {
+      limittable.remove();
+      hc.flags &= ~hot_ratelimit;
+   }
+   write_hot_config( hottable, hc, st.issuer );
+}
+
+void token::setfee( const symbol_code& symbolcode, const uint16_t& basis_points, const asset& max_fee,
+                    const name& treasury, const uint32_t& shards )
+{
+   check( basis_points <= 10000, "fee exceeds 10000 basis points" );
+   check( shards > 0 && shards <= max_fee_shards, "shard count out of range" );
+   auto sym_code_raw = symbolcode.raw();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   configs configtable( get_self(), sym_code_raw );
+   const auto& cf = configtable.get();
+   check( cf.config_locked_until.time_since_epoch() < current_time_point().time_since_epoch(),
+          "token reconfiguration is locked" );
+   check( max_fee.symbol == st.supply.symbol, "symbol precision mismatch" );
+   check( max_fee.amount >= 0, "fee cap must be non-negative" );
+   accounts acnts( get_self(), treasury.value );
+   check( acnts.find( sym_code_raw ) != acnts.end(), "treasury account must have a balance" );
+   feeconfigs( get_self(), sym_code_raw ).set( fee_config{ .basis_points = basis_points, .max_fee = max_fee,
+                                                           .treasury = treasury, .shards = shards }, st.issuer );
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get_or_default( make_hot_config( st, cf ) );
+   hc.flags = basis_points > 0 ? hc.flags | hot_fees : hc.flags & ~hot_fees;
+   write_hot_config( hottable, hc, st.issuer );
+}
+
+void token::sweepfees( const symbol_code& symbolcode, const uint32_t& limit )
+{
+   check( limit > 0 && limit <= max_fee_shards, "limit out of range" );
+   auto sym_code_raw = symbolcode.raw();
+   const auto hc = get_hot_config( sym_code_raw );
+   check( !(hc.flags & hot_migrating), "token is migrating" );
+   feeshards shardtable( get_self(), sym_code_raw );
+   check( shardtable.begin() != shardtable.end(), "no fees to sweep" );
+   const auto fc = feeconfigs( get_self(), sym_code_raw ).get();
+   asset total{ 0, hc.supply_symbol };
+   uint32_t counter = 0;
+   auto itr = shardtable.begin();
+   for( ; itr != shardtable.end() && counter<limit; counter++ ) {
+      total += itr->accrued;
+      itr = shardtable.erase( itr );
+   }
+   if( total.amount > 0 ) {
+      balance_ledger ledger( get_self() );
+      ledger.set_config( sym_code_raw, hc );
+      ledger.add( fc.treasury, total, get_self() );
+      ledger.record( get_self(), fc.treasury, total, "" );
+      ledger.flush();
+   }
+   print( "swept ", total, " from ", counter, " shards, ",
+          itr == shardtable.end() ? "done\n" : "more remain\n" );
+}
+
+#if RAINBOW_STAKING
+void token::settle( const symbol_code& symbolcode, const uint64_t& first_id, const uint32_t& limit )
+{
+   check( limit > 0 && limit <= max_settle_count, "limit out of range" );
+   settlements settletable( get_self(), symbolcode.raw() );
+   auto itr = settletable.lower_bound( first_id );
+   check( itr != settletable.end(), "nothing to settle" );
+   escrows escrowtable( get_self(), symbolcode.raw() );
+   stakes stakestable( get_self(), symbolcode.raw() );
+   // net amount owed by each owner to each escrow, by (contract, owner, escrow, stake symbol)
+   std::map<std::tuple<uint64_t, uint64_t, uint64_t, uint64_t>, asset> owed;
+   std::map<uint64_t, int64_t> settled;  // by stake index
+   uint32_t counter = 0;
+   for( ; itr != settletable.end() && counter<limit; counter++ ) {
+      auto key = std::make_tuple( itr->stake_token_contract.value, itr->owner.value,
+                                  itr->stake_to.value, itr->amount.symbol.raw() );
+      auto net = owed.try_emplace( key, 0, itr->amount.symbol ).first;
+      net->second += itr->amount;
+      // the row was counted in pending when it was accrued; now the escrow holds it, unless
+      // setstake has since moved the stake and reset its escrow row
+      auto sk = stakestable.find( itr->stake_index );
+      if( sk != stakestable.end() && sk->stake_to == itr->stake_to ) {
+         settled[itr->stake_index] += itr->amount.amount;
+      }
+      itr = settletable.erase(itr);
+   }
+   for( const auto& [stake_index, amount] : settled ) {
+      auto escrow = escrowtable.find( stake_index );
+      if( escrow != escrowtable.end() ) {
+         escrowtable.modify( escrow, same_payer, [&]( auto& e ) {
+            e.escrowed.amount += amount;
+            e.pending.amount  -= amount;
+         });
+      }
+   }
+   for( const auto& [key, amount] : owed ) {
+      if( amount.amount == 0 ) {
+         continue;
+      }
+      bool staking = amount.amount > 0;
+      name owner{ std::get<1>(key) };
+      name stake_to{ std::get<2>(key) };
+      name from = staking ? owner : stake_to;
+      name to = staking ? stake_to : owner;
+      asset stake_quantity = staking ? amount : -amount;
+      RAINBOW_TRACE_PRINT( "settle ", stake_quantity, " ", from, "->", to, "\n" );
+      action(
+         permission_level{from, "active"_n},
+         name{ std::get<0>(key) },
+         "transfer"_n,
+         std::make_tuple(from,
+                         to,
+                         stake_quantity,
+                         std::string(staking ? "rainbow stake" : "rainbow unstake"))
+      ).send();
+   }
+   print( "settled ", counter, " rows, ", itr == settletable.end() ? "done\n" : "more remain\n" );
+}
+#endif
+
+void token::migrate( const symbol_code& symbolcode, const std::vector<name>& owners )
+{
+   check( owners.size() <= max_migrate_count, "too many owners" );
+   auto sym_code_raw = symbolcode.raw();
+   migrations migtable( get_self(), sym_code_raw );
+   check( migtable.exists(), "no migration in progress" );
+   auto mg = migtable.get();
+   const auto& from = mg.migrated.symbol;
+   const auto& to = mg.rescaled.symbol;
+   auto flags = hot_flags( get_self(), sym_code_raw );
+   std::vector<name> walked;
+   if( owners.empty() ) {
+      check( flags & hot_holders, "owners are required unless the holders option is on" );
+      holders holdertable( get_self(), sym_code_raw );
+      auto itr = holdertable.lower_bound( mg.next.value );
+      for( ; itr != holdertable.end() && walked.size() < max_migrate_count; itr++ ) {
+         walked.push_back( itr->owner );
+      }
+      mg.next = itr != holdertable.end() ? itr->owner : name();
+   }
+   aggregate_delta delta;
+   for( const auto& owner : owners.empty() ? walked : owners ) {
+      accounts acnts( get_self(), owner.value );
+      auto row = acnts.find( sym_code_raw );
+      if( row == acnts.end() || row->balance.symbol != from ) {
+         continue;
+      }
+      bool held = row->balance.amount > 0;
+      mg.migrated += row->balance;
+      mg.rescaled += rescale( row->balance, to );
+      mg.rows++;
+      acnts.modify( row, same_payer, [&]( auto& a ) {
+         a.balance = rescale( a.balance, to );
+      });
+      if( flags & hot_holders ) {
+         index_holder( get_self(), owner, row->balance, name() );
+      }
+      if( held && row->balance.amount == 0 ) {
+         // rounded down to nothing at a lower precision
+         delta.holders--;
+         delta.zero_rows++;
+      }
+   }
+   if( flags & hot_tokenstats ) {
+      update_aggregates( get_self(), sym_code_raw, delta );
+   }
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   print( "migrated ", mg.migrated, " of ", st.supply, " in ", mg.rows, " rows\n" );
+   if( mg.migrated == st.supply ) {
+      // rounding down to a lower precision burns the truncated remainders
+      statstable.modify( st, same_payer, [&]( auto& s ) {
+         s.supply     = mg.rescaled;
+         s.max_supply = mg.max_supply;
+      });
+      finish_migration( symbolcode, mg );
+   } else {
+      migtable.set( mg, same_payer );
+   }
+}
+
+void token::endmigrate( const symbol_code& symbolcode )
+{
+   auto sym_code_raw = symbolcode.raw();
+   migrations migtable( get_self(), sym_code_raw );
+   check( migtable.exists(), "no migration in progress" );
+   const auto mg = migtable.get();
+   stats statstable( get_self(), sym_code_raw );
+   const auto& st = statstable.get( sym_code_raw, "token with symbol does not exist" );
+   require_auth( st.issuer );
+   // balances not reached are rescaled when they next change
+   auto residual = st.supply - mg.migrated;
+   statstable.modify( st, same_payer, [&]( auto& s ) {
+      s.supply     = mg.rescaled + rescale( residual, mg.rescaled.symbol );
+      s.max_supply = mg.max_supply;
+   });
+   print( "ended migration with ", residual, " not rescaled\n" );
+   finish_migration( symbolcode, mg );
+}
+
+void token::finish_migration( const symbol_code& symbolcode, const migration_stats& mg ) {
+   auto sym_code_raw = symbolcode.raw();
+   stakes stakestable( get_self(), sym_code_raw );
+   for( auto itr = stakestable.begin(); itr != stakestable.end(); itr++ ) {
+      stakestable.modify( itr, same_payer, [&]( auto& sk ) {
+         sk.token_bucket = rescale( sk.token_bucket, mg.rescaled.symbol );
+      });
+   }
+   hotconfigs hottable( get_self(), sym_code_raw );
+   auto hc = hottable.get();
+   hc.supply_symbol = mg.rescaled.symbol;
+   hc.flags &= ~hot_migrating;
+   hottable.set( hc, same_payer );
+   migrations( get_self(), sym_code_raw ).remove();
+   reset_circulating( symbolcode );
+}
+
+void token::indexholders( const symbol_code& symbolcode, const std::vector<name>& owners )
+{
+   check( owners.size() <= max_migrate_count, "too many owners" );
+   auto sym_code_raw = symbolcode.raw();
+   const auto hc = get_hot_config( sym_code_raw );
+   require_auth( hc.issuer );
+   check( hc.flags & hot_holders, "holders option is off" );
+   for( const auto& owner : owners ) {
+      accounts acnts( get_self(), owner.value );
+      auto row = acnts.find( sym_code_raw );
+      if( row != acnts.end() ) {
+         index_holder( get_self(), owner, row->balance, hc.issuer );
+      }
+   }
+}
+
+std::vector<token::balance_info> token::getbalances( const std::vector<name>& owners,
+                                                     const std::vector<symbol_code>& symbolcodes )
+{
+   check( owners.size() <= max_query_count, "too many owners" );
+   check( symbolcodes.size() <= max_query_count, "too many symbols" );
+   std::vector<balance_info> result;
+   for( const auto& owner : owners ) {
+      accounts acnts( get_self(), owner.value );
+      if( symbolcodes.empty() ) {
+         for( const auto& a : acnts ) {
+            result.push_back( balance_info{ owner, a.balance } );
+         }
+         continue;
+      }
+      for( const auto& code : symbolcodes ) {
+         auto row = acnts.find( code.raw() );
+         if( row != acnts.end() ) {
+            result.push_back( balance_info{ owner, row->balance } );
+         }
+      }
+   }
+   return result;
+}
+
+std::vector<token::token_info> token::gettokens( const std::vector<symbol_code>& symbolcodes )
+{
+   check( symbolcodes.size() <= max_query_count, "too many symbols" );
+   std::vector<token_info> result;
+   for( const auto& code : symbolcodes ) {
+      stats statstable( get_self(), code.raw() );
+      auto st = statstable.find( code.raw() );
+      if( st == statstable.end() ) {
+         continue;
+      }
+      const auto cf = configs( get_self(), code.raw() ).get();
+      result.push_back( token_info{
+         .supply         = st->supply,
+         .max_supply     = st->max_supply,
+         .issuer         = st->issuer,
+         .membership_mgr = cf.membership_mgr,
+         .withdrawal_mgr = cf.withdrawal_mgr,
+         .withdraw_to    = cf.withdraw_to,
+         .freeze_mgr     = cf.freeze_mgr,
+         .flags          = get_hot_config( code.raw() ).flags,
+         .display        = get_display( code.raw() )
+      });
+   }
+   return result;
+}
+
+std::vector<token::balance_info> token::getsnapshot( const symbol_code& symbolcode, const time_point_sec& time,
+                                                     const std::vector<name>& owners )
+{
+   check( owners.size() <= max_query_count, "too many owners" );
+   auto sym_code_raw = symbolcode.raw();
+   const auto hc = get_hot_config( sym_code_raw );
+   check( hc.flags & hot_checkpoints, "checkpoints are off" );
+   checkpoints cktable( get_self(), sym_code_raw );
+   auto ckidx = cktable.get_index<"ownerepoch"_n>();
+   std::vector<balance_info> result;
+   result.reserve( owners.size() );
+   for( const auto& owner : owners ) {
+      uint128_t first = (uint128_t)owner.value<<64;
+      asset balance{ 0, hc.supply_symbol };
+      auto after = ckidx.upper_bound( first | time.sec_since_epoch() );
+      auto oldest = ckidx.lower_bound( first );
+      if( oldest == ckidx.end() || oldest->owner != owner ) {
+         // no change since checkpoints were switched on
+         accounts acnts( get_self(), owner.value );
+         auto row = acnts.find( sym_code_raw );
+         if( row != acnts.end() ) {
+            balance = row->balance;
+         }
+      } else {
+         // before the retained history, the oldest row is the best known
+         balance = (after == oldest ? oldest : std::prev( after ))->balance;
+      }
+      // checkpoints written before a precision migration keep the old precision
+      result.push_back( balance_info{ owner, balance.symbol == hc.supply_symbol ? balance
+                                                                                 : rescale( balance, hc.supply_symbol ) } );
+   }
+   return result;
+}
+
+token::display_info token::get_display( uint64_t sym_code_raw ) const {
+   if constexpr( !with_display ) {
+      return display_info{};
+   }
+   displayrefs reftable( get_self(), sym_code_raw );
+   if( !reftable.exists() ) {
+      // display set before displayrefs existed
+      const auto dt = displays( get_self(), sym_code_raw ).get_or_default( currency_display{} );
+      return display_info{ dt.name, dt.logo, dt.logo_lg, dt.web_link, dt.background, dt.json_meta };
+   }
+   const auto dr = reftable.get();
+   blobs blobtable( get_self(), get_self().value );
+   auto text = [&]( uint64_t id ) {
+      return id == 0 ? string() : blobtable.get( id, "blob not found" ).data;
+   };
+   return display_info{ dr.name, text( dr.logo ), text( dr.logo_lg ), text( dr.web_link ),
+                        text( dr.background ), text( dr.json_meta ) };
+}
+
+asset token::rescale( const asset& value, const symbol& sym ) {
+   int64_t amount = value.amount;
+   for( auto p = value.symbol.precision(); p < sym.precision(); p++ ) {
+      check( amount <= asset::max_amount / 10, "rescaled amount overflows" );
+      amount *= 10;
+   }
+   for( auto p = value.symbol.precision(); p > sym.precision(); p-- ) {
+      amount /= 10;
+   }
+   return asset{ amount, sym };
+}
+
+#if RAINBOW_RESETRAM
+void token::resetram( const name& table, const string& scope, const uint32_t& limit )
+{
+   require_auth2( get_self().value, "active"_n.value );
+   check( !scope.empty(), "scope string is empty" );
+   check( limit > 0, "limit must be positive" );
+   // scope may list several symbol codes or owners separated by commas;
+   // they are cleared in order until limit rows have been erased
+   uint32_t remaining = limit;
+   for( size_t start = 0; start <= scope.size() && remaining > 0; ) {
+      size_t end = std::min( scope.find( ',', start ), scope.size() );
+      if( end > start ) {
+         remaining -= reset_scope( table, scope.substr( start, end - start ), remaining );
+      }
+      start = end + 1;
+   }
+}
+
+uint32_t token::reset_scope( const name& table, const string& scope, uint32_t limit )
+{
+   uint64_t scope_raw;
+   check( !scope.empty(), "scope string is empty" );
+   if( isupper(scope.c_str()[0]) ) {
+      symbol_code code(scope);
+      check( code.is_valid(), "invalid symbol code" );
+      scope_raw = code.raw();
+   } else {
+      name n(scope);
+      scope_raw = n.value;
+   }
+   // a scope that takes more than one call resumes at the row where the last call stopped
+   cleanups cleanuptable( get_self(), table.value );
+   auto cursor = cleanuptable.find( scope_raw );
+   uint64_t next = cursor != cleanuptable.end() ? cursor->next : 0;
+   uint32_t remaining = limit;
+   bool more = false;
+   // tables with secondary indices are erased through multi_index so index rows go too
+   if( table == "stakes"_n ) {
+      more = !erase_rows( stakes( get_self(), scope_raw ), next, remaining );
+   } else if( table == "blobs"_n ) {
+      // a blob still referred to is released with the displayrefs row of its token
+      blobs blobtable( get_self(), scope_raw );
+      auto itr = blobtable.lower_bound( next );
+      for( uint32_t visited = 0; itr != blobtable.end() && visited<limit; visited++ ) {
+         if( itr->refs > 0 ) {
+            itr++;
+         } else {
+            itr = blobtable.erase(itr);
+            remaining--;
+         }
+      }
+      more = itr != blobtable.end();
+      next = more ? itr->primary_key() : 0;
+   } else if( table == "displayrefs"_n ) {
+      if( displayrefs( get_self(), scope_raw ).exists() ) {
+         release_display( scope_raw );
+         remaining--;
+      }
+   } else if( table == "holders"_n ) {
+      more = !erase_rows( holders( get_self(), scope_raw ), next, remaining );
+   } else if( table == "settlements"_n ) {
+      more = !erase_rows( settlements( get_self(), scope_raw ), next, remaining );
+   } else if( table == "schedules"_n ) {
+      more = !erase_rows( schedules( get_self(), scope_raw ), next, remaining );
+   } else if( table == "checkpoints"_n ) {
+      more = !erase_rows( checkpoints( get_self(), scope_raw ), next, remaining );
+   } else if( table == "recent"_n ) {
+      more = !erase_rows( recents( get_self(), scope_raw ), next, remaining );
+   } else if( table == "allowances"_n ) {
+      more = !erase_rows( allowances( get_self(), scope_raw ), next, remaining );
+   } else {
+     // generic erase for tables with no secondary indices
+     auto it = internal_use_do_not_use::db_lowerbound_i64(_self.value, scope_raw, table.value, next);
+     for( ; it >= 0 && remaining > 0; remaining-- ) {
+        auto del = it;
+        it = internal_use_do_not_use::db_next_i64(it, &next);
+        internal_use_do_not_use::db_remove_i64(del);
+     }
+     more = it >= 0;
+   }
+   uint32_t counter = limit - remaining;
+   uint64_t total = counter + ( cursor != cleanuptable.end() ? cursor->erased : 0 );
+   if( more ) {
+      if( cursor == cleanuptable.end() ) {
+         cleanuptable.emplace( get_self(), [&]( auto& c ) {
+            c.scope  = scope_raw;
+            c.erased = total;
+            c.next   = next;
+         });
+      } else {
+         cleanuptable.modify( cursor, same_payer, [&]( auto& c ) {
+            c.erased = total;
+            c.next   = next;
+         });
+      }
+   } else if( cursor != cleanuptable.end() ) {
+      cleanuptable.erase( cursor );
+   }
+   print( "resetram ", table, " ", scope, ": erased ", counter, ", ", total, " in all, ",
+          more ? "more remain\n" : "done\n" );
+   return counter;
 }
+#endif
 
 
 } /// namespace eosio
@@ -0,0 +1,24 @@
+# Feature variants of the rainbowtoken contract; see README.txt and the RAINBOW_<feature>
+# macros in include/rainbow.hpp. Shared by the contract build and the native build.
+
+set( RAINBOW_VARIANTS full nostake nodisplay lite )
+
+# sets `out` to the compile definitions that build `variant`
+function( rainbow_variant_definitions variant out )
+   if( variant STREQUAL "full" )
+      set( off "" )
+   elseif( variant STREQUAL "nostake" )
+      set( off STAKING )
+   elseif( variant STREQUAL "nodisplay" )
+      set( off DISPLAY )
+   elseif( variant STREQUAL "lite" )
+      set( off STAKING DISPLAY MEMBERSHIP WITHDRAWAL RESETRAM )
+   else()
+      message( FATAL_ERROR "unknown contract variant '${variant}'; use one of: ${RAINBOW_VARIANTS}" )
+   endif()
+   set( definitions "" )
+   foreach( feature ${off} )
+      list( APPEND definitions RAINBOW_${feature}=0 )
+   endforeach()
+   set( ${out} ${definitions} PARENT_SCOPE )
+endfunction()